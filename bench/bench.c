@@ -0,0 +1,170 @@
+/**
+ * @file bench.c
+ * @brief Implementation of the microbenchmark harness.
+ */
+
+#include "bench.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** @brief Upper bound on --samples, so sample storage can live on the stack. */
+#define BENCH_MAX_SAMPLES 1000
+
+static double
+now_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static void
+bench_usage(const char *suite)
+{
+	fprintf(stderr,
+	    "usage: %s [--csv | --json] [--no-header] [--quick]\n"
+	    "       [--samples N] [--warmup N] [--min-ms N] [--filter TEXT]"
+	    " [ARGS...]\n", suite);
+}
+
+int
+bench_init(bench_config *cfg, const char *suite, int argc, char **argv)
+{
+	cfg->suite = suite;
+	cfg->format = BENCH_FORMAT_TEXT;
+	cfg->header = 1;
+	cfg->warmup = 2;
+	cfg->samples = 21;
+	cfg->min_sample = 0.005;
+	cfg->filter = NULL;
+	cfg->out = stdout;
+
+	int i = 1;
+	for (; i < argc && strncmp(argv[i], "--", 2) == 0; ++i) {
+		const char *opt = argv[i];
+		const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+		if (strcmp(opt, "--") == 0) {
+			return i + 1;
+		} else if (strcmp(opt, "--csv") == 0) {
+			cfg->format = BENCH_FORMAT_CSV;
+		} else if (strcmp(opt, "--json") == 0) {
+			cfg->format = BENCH_FORMAT_JSON;
+		} else if (strcmp(opt, "--no-header") == 0) {
+			cfg->header = 0;
+		} else if (strcmp(opt, "--quick") == 0) {
+			cfg->samples = 5;
+			cfg->min_sample = 0.001;
+		} else if (strcmp(opt, "--samples") == 0 && val) {
+			cfg->samples = (size_t) strtoul(val, NULL, 10);
+			++i;
+		} else if (strcmp(opt, "--warmup") == 0 && val) {
+			cfg->warmup = (size_t) strtoul(val, NULL, 10);
+			++i;
+		} else if (strcmp(opt, "--min-ms") == 0 && val) {
+			cfg->min_sample = strtod(val, NULL) / 1e3;
+			++i;
+		} else if (strcmp(opt, "--filter") == 0 && val) {
+			cfg->filter = val;
+			++i;
+		} else {
+			bench_usage(suite);
+			return -1;
+		}
+	}
+
+	if (cfg->samples == 0) {
+		cfg->samples = 1;
+	}
+	if (cfg->samples > BENCH_MAX_SAMPLES) {
+		cfg->samples = BENCH_MAX_SAMPLES;
+	}
+
+	if (cfg->header && cfg->format == BENCH_FORMAT_TEXT) {
+		fprintf(cfg->out, "%-14s %-22s %-10s %10s %12s %12s %10s\n",
+		    "suite", "case", "variant", "bytes", "median ns", "p99 ns",
+		    "MB/s");
+	} else if (cfg->header && cfg->format == BENCH_FORMAT_CSV) {
+		fprintf(cfg->out, "suite,case,variant,bytes,iterations,"
+		    "samples,median_ns,p99_ns,min_ns,bytes_per_sec\n");
+	}
+	return i;
+}
+
+static int
+bench_compare_double(const void *lhs, const void *rhs)
+{
+	double a = *(const double *) lhs;
+	double b = *(const double *) rhs;
+	return (a > b) - (a < b);
+}
+
+/** @brief Time @p iters back-to-back calls; returns seconds per call. */
+static double
+bench_sample(bench_fn fn, void *arg, size_t iters)
+{
+	double start = now_seconds();
+	for (size_t i = 0; i < iters; ++i) {
+		fn(arg);
+	}
+	return (now_seconds() - start) / (double) iters;
+}
+
+void
+bench_run(const bench_config *cfg, const char *name, const char *variant,
+    size_t bytes, bench_fn fn, void *arg)
+{
+	if (cfg->filter && !strstr(name, cfg->filter)) {
+		return;
+	}
+
+	for (size_t i = 0; i < cfg->warmup; ++i) {
+		fn(arg);
+	}
+
+	// Double the repetitions until one sample is long enough for the
+	// clock to resolve it.
+	size_t iters = 1;
+	while (bench_sample(fn, arg, iters) * (double) iters <
+	    cfg->min_sample && iters < SIZE_MAX / 2) {
+		iters *= 2;
+	}
+
+	double times[BENCH_MAX_SAMPLES];
+	for (size_t s = 0; s < cfg->samples; ++s) {
+		times[s] = bench_sample(fn, arg, iters);
+	}
+	qsort(times, cfg->samples, sizeof(times[0]), bench_compare_double);
+
+	// Nearest rank; with fewer than 100 samples p99 is the slowest one.
+	size_t n = cfg->samples;
+	double median = n % 2 ? times[n / 2] :
+	    (times[n / 2 - 1] + times[n / 2]) / 2.0;
+	size_t rank = (99 * n + 99) / 100;
+	double p99 = times[rank - 1];
+	double rate = median > 0.0 ? (double) bytes / median : 0.0;
+
+	switch (cfg->format) {
+	case BENCH_FORMAT_CSV:
+		fprintf(cfg->out, "%s,%s,%s,%zu,%zu,%zu,%.1f,%.1f,%.1f,%.0f\n",
+		    cfg->suite, name, variant, bytes, iters, n, median * 1e9,
+		    p99 * 1e9, times[0] * 1e9, rate);
+		break;
+	case BENCH_FORMAT_JSON:
+		fprintf(cfg->out, "{\"suite\":\"%s\",\"case\":\"%s\","
+		    "\"variant\":\"%s\",\"bytes\":%zu,\"iterations\":%zu,"
+		    "\"samples\":%zu,\"median_ns\":%.1f,\"p99_ns\":%.1f,"
+		    "\"min_ns\":%.1f,\"bytes_per_sec\":%.0f}\n", cfg->suite,
+		    name, variant, bytes, iters, n, median * 1e9, p99 * 1e9,
+		    times[0] * 1e9, rate);
+		break;
+	default:
+		fprintf(cfg->out, "%-14s %-22s %-10s %10zu %12.1f %12.1f "
+		    "%10.1f\n", cfg->suite, name, variant, bytes, median * 1e9,
+		    p99 * 1e9, rate / 1e6);
+		break;
+	}
+	fflush(cfg->out);
+}
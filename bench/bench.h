@@ -0,0 +1,66 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/**
+ * @file bench.h
+ * @brief Shared microbenchmark harness: warm-up, sampling and reporting.
+ *
+ * Each case is warmed up, calibrated so that one sample repeats the body
+ * for at least a minimum time, then sampled repeatedly. The median and p99
+ * time per call and the throughput at the median are reported as an
+ * aligned table, CSV or JSON Lines, so runs can be diffed across commits.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+
+typedef enum
+{
+	BENCH_FORMAT_TEXT = 0,
+	BENCH_FORMAT_CSV,
+	BENCH_FORMAT_JSON	/**< One JSON object per line. */
+} bench_format;
+
+/**
+ * @brief Settings shared by every case of one benchmark binary.
+ */
+typedef struct
+{
+	const char *suite;	/**< Binary name reported with every case. */
+	bench_format format;
+	int header;		/**< Print the table or CSV header. */
+	size_t warmup;		/**< Untimed calls before calibration. */
+	size_t samples;		/**< Timed samples per case. */
+	double min_sample;	/**< Seconds one sample must at least take. */
+	const char *filter;	/**< Only run cases whose name contains this. */
+	FILE *out;
+} bench_config;
+
+/** @brief Body of a case; called repeatedly with the case's argument. */
+typedef void (*bench_fn)(void *arg);
+
+/**
+ * @brief Fill @p cfg with defaults and apply the common options.
+ *
+ * Recognised options: --csv, --json, --no-header, --quick,
+ * --samples N, --warmup N, --min-ms N and --filter TEXT.
+ *
+ * @return Index of the first argument that is not an option, or -1 after
+ *         printing usage for an unknown option.
+ */
+int bench_init(bench_config * cfg, const char *suite, int argc, char **argv);
+
+/**
+ * @brief Measure one case and report it.
+ *
+ * @param cfg     Settings from bench_init().
+ * @param name    Case name, typically the primitive measured.
+ * @param variant Implementation or input kind, e.g. a dispatch level.
+ * @param bytes   Bytes processed per call, for throughput; 0 for none.
+ * @param fn      Body to time.
+ * @param arg     Argument passed to @p fn.
+ */
+void bench_run(const bench_config * cfg, const char *name,
+    const char *variant, size_t bytes, bench_fn fn, void *arg);
+
+#endif /* BENCH_H */
@@ -0,0 +1,82 @@
+/**
+ * @file bench_aes.c
+ * @brief Microbenchmark: AES-128-ECB throughput per dispatch level.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "aes.h"
+#include "bench.h"
+#include "cpu_features.h"
+
+#define BENCH_MAX_LEN (1u << 20)
+
+typedef struct
+{
+	aes128_key ks;
+	uint8_t *buf;
+	size_t len;
+} aes_case;
+
+static void
+run_encrypt(void *arg)
+{
+	aes_case *c = arg;
+	aes128_ecb_encrypt(&c->ks, c->buf, c->buf, c->len);
+}
+
+static void
+run_decrypt(void *arg)
+{
+	aes_case *c = arg;
+	aes128_ecb_decrypt(&c->ks, c->buf, c->buf, c->len);
+}
+
+int
+main(int argc, char **argv)
+{
+	static const struct
+	{
+		const char *name;
+		unsigned mask;
+	} levels[] = {
+		{ "portable", 0 },
+		{ "aesni", ~0u }
+	};
+	static const size_t sizes[] = { 64, 4096, BENCH_MAX_LEN };
+
+	bench_config cfg;
+	if (bench_init(&cfg, "aes", argc, argv) < 0) {
+		return EXIT_FAILURE;
+	}
+
+	aes_case c;
+	c.buf = malloc(BENCH_MAX_LEN);
+	if (!c.buf) {
+		fprintf(stderr, "bench_aes: out of memory\n");
+		return EXIT_FAILURE;
+	}
+	for (size_t i = 0; i < BENCH_MAX_LEN; ++i) {
+		c.buf[i] = (uint8_t) (i * 131u);
+	}
+
+	const uint8_t key[AES128_KEY_SIZE] = "YELLOW SUBMARINE";
+	aes128_expand_key(&c.ks, key);
+
+	for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); ++l) {
+		cpu_features_set_mask(levels[l].mask);
+		for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+			c.len = sizes[s];
+			bench_run(&cfg, "aes128_ecb_encrypt", levels[l].name,
+			    c.len, run_encrypt, &c);
+			bench_run(&cfg, "aes128_ecb_decrypt", levels[l].name,
+			    c.len, run_decrypt, &c);
+		}
+	}
+
+	cpu_features_set_mask(~0u);
+	free(c.buf);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file bench_base64.c
+ * @brief Microbenchmark: Base64 encode/decode throughput per dispatch level.
+ *
+ * Throughput is measured on the bytes side. The wrapped decode case reads
+ * text broken into 76-column lines.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "base64.h"
+#include "bench.h"
+#include "cpu_features.h"
+#include "hex2b64.h"
+
+#define BENCH_MAX_LEN (1u << 20)
+#define BENCH_LINE 76
+
+typedef struct
+{
+	uint8_t *bytes;
+	uint8_t *text;
+	size_t len;		/**< Raw bytes per call. */
+	size_t text_len;	/**< Base64 characters for @c len bytes. */
+	size_t text_cap;
+} base64_case;
+
+static void
+run_encode(void *arg)
+{
+	base64_case *c = arg;
+	bytes_to_base64(c->bytes, c->len, c->text, c->text_cap, NULL);
+}
+
+static void
+run_decode(void *arg)
+{
+	base64_case *c = arg;
+	base64_to_bytes(c->text, c->text_len, c->bytes, BENCH_MAX_LEN, NULL,
+	    NULL);
+}
+
+int
+main(int argc, char **argv)
+{
+	static const struct
+	{
+		const char *name;
+		unsigned mask;
+	} levels[] = {
+		{ "scalar", 0 },
+		{ "ssse3", CPU_FEATURE_SSE2 | CPU_FEATURE_SSSE3 },
+		{ "avx2", ~0u }
+	};
+	// Multiples of 3 so the encoded text has no padding mid-buffer.
+	static const size_t sizes[] = { 48, 3 * 1024, 3 * 349525 };
+
+	bench_config cfg;
+	if (bench_init(&cfg, "base64", argc, argv) < 0) {
+		return EXIT_FAILURE;
+	}
+
+	const size_t text_cap = (BENCH_MAX_LEN + 2) / 3 * 4;
+	const size_t wrapped_cap = text_cap + text_cap / BENCH_LINE + 1;
+	uint8_t *bytes = malloc(BENCH_MAX_LEN);
+	uint8_t *text = malloc(text_cap);
+	uint8_t *wrapped = malloc(wrapped_cap);
+	if (!bytes || !text || !wrapped) {
+		fprintf(stderr, "bench_base64: out of memory\n");
+		free(bytes);
+		free(text);
+		free(wrapped);
+		return EXIT_FAILURE;
+	}
+
+	uint32_t state = 0x9E3779B9u;
+	for (size_t i = 0; i < BENCH_MAX_LEN; ++i) {
+		state = state * 1103515245u + 12345u;
+		bytes[i] = (uint8_t) (state >> 24);
+	}
+
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+		base64_case plain = { bytes, text, sizes[s], 0, text_cap };
+		bytes_to_base64(bytes, plain.len, text, text_cap,
+		    &plain.text_len);
+
+		base64_case wrap = plain;
+		wrap.text = wrapped;
+		wrap.text_len = 0;
+		for (size_t i = 0; i < plain.text_len; ++i) {
+			wrapped[wrap.text_len++] = text[i];
+			if ((i + 1) % BENCH_LINE == 0) {
+				wrapped[wrap.text_len++] = '\n';
+			}
+		}
+
+		for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]);
+		    ++l) {
+			cpu_features_set_mask(levels[l].mask);
+			bench_run(&cfg, "bytes_to_base64", levels[l].name,
+			    plain.len, run_encode, &plain);
+			bench_run(&cfg, "base64_to_bytes", levels[l].name,
+			    plain.len, run_decode, &plain);
+			bench_run(&cfg, "base64_to_bytes/76", levels[l].name,
+			    plain.len, run_decode, &wrap);
+		}
+	}
+
+	cpu_features_set_mask(~0u);
+	free(bytes);
+	free(text);
+	free(wrapped);
+	return EXIT_SUCCESS;
+}
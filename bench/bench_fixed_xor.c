@@ -0,0 +1,86 @@
+/**
+ * @file bench_fixed_xor.c
+ * @brief Microbenchmark: fixed_xor_buffers() throughput across sizes.
+ *
+ * Sizes double from 16 bytes up to a maximum given in MiB as the first
+ * argument after the harness options (default 1024, i.e. 1 GiB). Buffers
+ * are XORed in place.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "cpu_features.h"
+#include "fixed_xor.h"
+
+typedef struct
+{
+	uint8_t *lhs;
+	const uint8_t *rhs;
+	size_t len;
+} fixed_xor_case;
+
+static void
+run_xor(void *arg)
+{
+	fixed_xor_case *c = arg;
+	fixed_xor_buffers(c->lhs, c->rhs, c->lhs, c->len);
+}
+
+int
+main(int argc, char **argv)
+{
+	static const struct
+	{
+		const char *name;
+		unsigned mask;
+	} levels[] = {
+		{ "scalar", 0 },
+		{ "sse2", CPU_FEATURE_SSE2 },
+		{ "avx2", CPU_FEATURE_SSE2 | CPU_FEATURE_AVX2 },
+		{ "avx512", ~0u }
+	};
+
+	bench_config cfg;
+	int arg = bench_init(&cfg, "fixed_xor", argc, argv);
+	if (arg < 0) {
+		return EXIT_FAILURE;
+	}
+
+	size_t max_len = (size_t) 1024 << 20;
+	if (arg < argc) {
+		max_len = (size_t) strtoul(argv[arg], NULL, 10) << 20;
+	}
+	if (max_len < 16) {
+		max_len = 16;
+	}
+
+	uint8_t *lhs = malloc(max_len);
+	uint8_t *rhs = malloc(max_len);
+	if (!lhs || !rhs) {
+		fprintf(stderr, "bench_fixed_xor: out of memory\n");
+		free(lhs);
+		free(rhs);
+		return EXIT_FAILURE;
+	}
+	memset(lhs, 0x5A, max_len);
+	memset(rhs, 0xA5, max_len);
+
+	for (size_t len = 16; len <= max_len; len *= 2) {
+		fixed_xor_case c = { lhs, rhs, len };
+		for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]);
+		    ++l) {
+			cpu_features_set_mask(levels[l].mask);
+			bench_run(&cfg, "fixed_xor_buffers", levels[l].name,
+			    len, run_xor, &c);
+		}
+	}
+
+	cpu_features_set_mask(~0u);
+	free(lhs);
+	free(rhs);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file bench_hamming.c
+ * @brief Microbenchmark: Hamming distance throughput per dispatch level.
+ *
+ * Throughput counts the bytes of one operand.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "cpu_features.h"
+#include "hamming.h"
+
+#define BENCH_MAX_LEN (1u << 20)
+#define BENCH_BATCH 1024
+#define BENCH_ITEM 4096
+
+typedef struct
+{
+	const uint8_t *a;
+	const uint8_t *b;
+	const uint8_t **items;
+	uint64_t *dist;
+	size_t len;
+	volatile uint64_t sink;
+} hamming_case;
+
+static void
+run_distance(void *arg)
+{
+	hamming_case *c = arg;
+	uint64_t bits = 0;
+	hamming_distance(c->a, c->b, c->len, &bits);
+	c->sink += bits;
+}
+
+static void
+run_batch(void *arg)
+{
+	hamming_case *c = arg;
+	hamming_distance_batch(c->a, c->items, BENCH_BATCH, BENCH_ITEM,
+	    c->dist);
+	c->sink += c->dist[0];
+}
+
+int
+main(int argc, char **argv)
+{
+	static const struct
+	{
+		const char *name;
+		unsigned mask;
+	} levels[] = {
+		{ "portable", 0 },
+		{ "popcnt", CPU_FEATURE_POPCNT },
+		{ "avx2", CPU_FEATURE_POPCNT | CPU_FEATURE_AVX2 },
+		{ "avx512", ~0u }
+	};
+	static const size_t sizes[] = { 64, 4096, BENCH_MAX_LEN };
+
+	bench_config cfg;
+	if (bench_init(&cfg, "hamming", argc, argv) < 0) {
+		return EXIT_FAILURE;
+	}
+
+	uint8_t *a = malloc(BENCH_MAX_LEN);
+	uint8_t *b = malloc((size_t) BENCH_BATCH * BENCH_ITEM);
+	const uint8_t **items = malloc(BENCH_BATCH * sizeof(*items));
+	uint64_t *dist = malloc(BENCH_BATCH * sizeof(*dist));
+	if (!a || !b || !items || !dist) {
+		fprintf(stderr, "bench_hamming: out of memory\n");
+		free(a);
+		free(b);
+		free(items);
+		free(dist);
+		return EXIT_FAILURE;
+	}
+
+	uint32_t state = 0x9E3779B9u;
+	for (size_t i = 0; i < BENCH_MAX_LEN; ++i) {
+		state = state * 1103515245u + 12345u;
+		a[i] = (uint8_t) (state >> 24);
+	}
+	for (size_t i = 0; i < (size_t) BENCH_BATCH * BENCH_ITEM; ++i) {
+		state = state * 1103515245u + 12345u;
+		b[i] = (uint8_t) (state >> 24);
+	}
+	for (size_t i = 0; i < BENCH_BATCH; ++i) {
+		items[i] = b + i * BENCH_ITEM;
+	}
+
+	if (!cpu_has(CPU_FEATURE_AVX512VPOPCNTDQ)) {
+		fprintf(stderr, "bench_hamming: no AVX-512 VPOPCNTQ, the "
+		    "avx512 rows use AVX2\n");
+	}
+
+	hamming_case c = { a, b, items, dist, 0, 0 };
+	for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); ++l) {
+		cpu_features_set_mask(levels[l].mask);
+		for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+			c.len = sizes[s];
+			bench_run(&cfg, "hamming_distance", levels[l].name,
+			    c.len, run_distance, &c);
+		}
+		bench_run(&cfg, "hamming_distance_batch", levels[l].name,
+		    (size_t) BENCH_BATCH * BENCH_ITEM, run_batch, &c);
+	}
+
+	cpu_features_set_mask(~0u);
+	free(a);
+	free(b);
+	free(items);
+	free(dist);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file bench_hex.c
+ * @brief Microbenchmark: hex encode/decode and hex-to-Base64 per dispatch
+ * level and input size.
+ *
+ * Throughput is measured on the bytes side: a decode of 2n hex digits
+ * counts n bytes.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "cpu_features.h"
+#include "hex2b64.h"
+#include "utils.h"
+
+#define BENCH_MAX_LEN (1u << 20)
+
+typedef struct
+{
+	uint8_t *bytes;
+	char *hex;
+	uint8_t *b64;
+	size_t len;
+} hex_case;
+
+static void
+run_encode(void *arg)
+{
+	hex_case *c = arg;
+	bytes_to_hex(c->bytes, c->len, c->hex, 2 * BENCH_MAX_LEN + 1);
+}
+
+static void
+run_decode(void *arg)
+{
+	hex_case *c = arg;
+	hex_to_bytes_n(c->hex, 2 * c->len, c->bytes, BENCH_MAX_LEN, NULL);
+}
+
+static void
+run_hex2b64(void *arg)
+{
+	hex_case *c = arg;
+	hex2b64_buffer((const uint8_t *) c->hex, 2 * c->len, c->b64,
+	    2 * BENCH_MAX_LEN, NULL);
+}
+
+int
+main(int argc, char **argv)
+{
+	static const struct
+	{
+		const char *name;
+		unsigned mask;
+	} levels[] = {
+		{ "scalar", 0 },
+		{ "sse", CPU_FEATURE_SSE2 | CPU_FEATURE_SSSE3 },
+		{ "avx2", ~0u }
+	};
+	static const size_t sizes[] = { 64, 4096, BENCH_MAX_LEN };
+
+	bench_config cfg;
+	if (bench_init(&cfg, "hex", argc, argv) < 0) {
+		return EXIT_FAILURE;
+	}
+
+	hex_case c;
+	c.bytes = malloc(BENCH_MAX_LEN);
+	c.hex = malloc(2 * BENCH_MAX_LEN + 1);
+	c.b64 = malloc(2 * BENCH_MAX_LEN);
+	if (!c.bytes || !c.hex || !c.b64) {
+		fprintf(stderr, "bench_hex: out of memory\n");
+		free(c.bytes);
+		free(c.hex);
+		free(c.b64);
+		return EXIT_FAILURE;
+	}
+
+	uint32_t state = 0x9E3779B9u;
+	for (size_t i = 0; i < BENCH_MAX_LEN; ++i) {
+		state = state * 1103515245u + 12345u;
+		c.bytes[i] = (uint8_t) (state >> 24);
+	}
+	bytes_to_hex(c.bytes, BENCH_MAX_LEN, c.hex, 2 * BENCH_MAX_LEN + 1);
+
+	for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); ++l) {
+		cpu_features_set_mask(levels[l].mask);
+		for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+			c.len = sizes[s];
+			bench_run(&cfg, "bytes_to_hex", levels[l].name, c.len,
+			    run_encode, &c);
+			bench_run(&cfg, "hex_to_bytes", levels[l].name, c.len,
+			    run_decode, &c);
+			bench_run(&cfg, "hex2b64_buffer", levels[l].name,
+			    c.len, run_hex2b64, &c);
+		}
+	}
+
+	cpu_features_set_mask(~0u);
+	free(c.bytes);
+	free(c.hex);
+	free(c.b64);
+	return EXIT_SUCCESS;
+}
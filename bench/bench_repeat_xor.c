@@ -0,0 +1,98 @@
+/**
+ * @file bench_repeat_xor.c
+ * @brief Microbenchmark: repeating-key XOR and the key breaker.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "repeat_xor.h"
+
+#define BENCH_MAX_LEN (1u << 20)
+#define BENCH_BREAK_LEN (64u * 1024u)
+
+typedef struct
+{
+	uint8_t *buf;
+	size_t len;
+	const uint8_t *key;
+	size_t key_len;
+	size_t threads;
+} repeat_case;
+
+static void
+run_xor(void *arg)
+{
+	repeat_case *c = arg;
+	repeating_key_xor(c->buf, c->buf, c->len, c->key, c->key_len);
+}
+
+static void
+run_break(void *arg)
+{
+	repeat_case *c = arg;
+	repeat_xor_candidate top[3];
+	size_t top_len = 0;
+	repeat_xor_break(c->buf, c->len, 2, 40, c->threads, top, 3, &top_len);
+}
+
+int
+main(int argc, char **argv)
+{
+	static const char text[] =
+	    "It was the best of times, it was the worst of times, it was "
+	    "the age of wisdom, it was the age of foolishness, it was the "
+	    "epoch of belief, it was the epoch of incredulity.\n";
+	static const size_t sizes[] = { 64, 4096, BENCH_MAX_LEN };
+	static const uint8_t key[] = "Terminator X: Bring the noise";
+	static const struct
+	{
+		const char *name;
+		size_t len;
+	} keys[] = {
+		{ "key3", 3 },
+		{ "key29", sizeof(key) - 1 }
+	};
+
+	bench_config cfg;
+	if (bench_init(&cfg, "repeat_xor", argc, argv) < 0) {
+		return EXIT_FAILURE;
+	}
+
+	uint8_t *buf = malloc(BENCH_MAX_LEN);
+	uint8_t *cipher = malloc(BENCH_BREAK_LEN);
+	if (!buf || !cipher) {
+		fprintf(stderr, "bench_repeat_xor: out of memory\n");
+		free(buf);
+		free(cipher);
+		return EXIT_FAILURE;
+	}
+	memset(buf, 'a', BENCH_MAX_LEN);
+
+	for (size_t k = 0; k < sizeof(keys) / sizeof(keys[0]); ++k) {
+		for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+			repeat_case c = { buf, sizes[s], key, keys[k].len, 0 };
+			bench_run(&cfg, "repeating_key_xor", keys[k].name,
+			    c.len, run_xor, &c);
+		}
+	}
+
+	for (size_t i = 0; i < BENCH_BREAK_LEN; ++i) {
+		cipher[i] = (uint8_t) text[i % (sizeof(text) - 1)];
+	}
+	repeating_key_xor(cipher, cipher, BENCH_BREAK_LEN, key,
+	    sizeof(key) - 1);
+	repeat_case one = { cipher, BENCH_BREAK_LEN, key, 0, 1 };
+	repeat_case all = { cipher, BENCH_BREAK_LEN, key, 0, 0 };
+	bench_run(&cfg, "repeat_xor_break", "1thread", one.len, run_break,
+	    &one);
+	bench_run(&cfg, "repeat_xor_break", "allcpus", all.len, run_break,
+	    &all);
+
+	free(buf);
+	free(cipher);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file bench_scan.c
+ * @brief Microbenchmark: corpus scanners (single-byte XOR and ECB) on one
+ * thread and on every CPU.
+ *
+ * The corpus is 4096 lines of 160 random bytes in hex, about 1.3 MB.
+ * Throughput counts corpus bytes.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "ecb_detect.h"
+#include "hex_corpus.h"
+#include "utils.h"
+#include "xor_scan.h"
+
+#define BENCH_LINES 4096u
+#define BENCH_LINE_BYTES 160
+
+typedef struct
+{
+	hex_corpus corpus;
+	size_t threads;
+} scan_case;
+
+static void
+run_xor_scan(void *arg)
+{
+	scan_case *c = arg;
+	xor_scan_result top[4];
+	size_t top_len = 0;
+	xor_scan_corpus(&c->corpus, c->threads, top, 4, &top_len, NULL);
+}
+
+static void
+run_ecb_detect(void *arg)
+{
+	scan_case *c = arg;
+	ecb_detect_result top[4];
+	size_t top_len = 0;
+	ecb_detect_corpus(&c->corpus, c->threads, top, 4, &top_len, NULL);
+}
+
+int
+main(int argc, char **argv)
+{
+	bench_config cfg;
+	if (bench_init(&cfg, "scan", argc, argv) < 0) {
+		return EXIT_FAILURE;
+	}
+
+	const size_t stride = 2 * BENCH_LINE_BYTES + 1;
+	const size_t size = BENCH_LINES * stride;
+	char *text = malloc(size + 1);
+	if (!text) {
+		fprintf(stderr, "bench_scan: out of memory\n");
+		return EXIT_FAILURE;
+	}
+
+	uint32_t state = 0x9E3779B9u;
+	for (size_t i = 0; i < BENCH_LINES; ++i) {
+		uint8_t bytes[BENCH_LINE_BYTES];
+		for (size_t j = 0; j < sizeof(bytes); ++j) {
+			state = state * 1103515245u + 12345u;
+			bytes[j] = (uint8_t) (state >> 24);
+		}
+		bytes_to_hex(bytes, sizeof(bytes), text + i * stride,
+		    stride + 1);
+		text[i * stride + stride - 1] = '\n';
+	}
+
+	scan_case one = { { NULL, 0, 0 }, 1 };
+	hex_corpus_from_buffer(text, size, &one.corpus);
+	scan_case all = one;
+	all.threads = 0;
+
+	bench_run(&cfg, "xor_scan_corpus", "1thread", size, run_xor_scan,
+	    &one);
+	bench_run(&cfg, "xor_scan_corpus", "allcpus", size, run_xor_scan,
+	    &all);
+	bench_run(&cfg, "ecb_detect_corpus", "1thread", size, run_ecb_detect,
+	    &one);
+	bench_run(&cfg, "ecb_detect_corpus", "allcpus", size, run_ecb_detect,
+	    &all);
+
+	free(text);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,275 @@
+/**
+ * @file bench_score_english.c
+ * @brief Microbenchmark: English scoring kernels and the single-byte XOR
+ * solvers built on them.
+ *
+ * The scorers run on random and English input against the original
+ * branchy loop. The solvers run on one line and on a batch of 30-byte
+ * lines shaped like assets/4.txt.
+ */
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "score_english_hex.h"
+#include "utils.h"
+
+#define BENCH_MAX_LEN (1u << 20)
+#define BENCH_LINES 327
+#define BENCH_LINE_BYTES 30
+
+/**
+ * @brief The original per-byte classification loop, kept as the baseline.
+ */
+static double
+score_reference(const uint8_t *bytes, size_t len)
+{
+	static const double freq[27] = {
+		0.0817, 0.0150, 0.0278, 0.0425, 0.1270, 0.0223, 0.0202,
+		0.0609, 0.0697, 0.0015, 0.0077, 0.0403, 0.0241, 0.0675,
+		0.0751, 0.0193, 0.0010, 0.0599, 0.0633, 0.0906, 0.0276,
+		0.0098, 0.0236, 0.0015, 0.0197, 0.0007, 0.1300
+	};
+	int counts[27] = { 0 };
+	size_t total_letters = 0;
+	double penalty = 0.0;
+
+	for (size_t i = 0; i < len; ++i) {
+		uint8_t c = bytes[i];
+		if (isalpha(c)) {
+			c = (uint8_t) tolower(c);
+			counts[c - 'a']++;
+			total_letters++;
+		} else if (c == ' ') {
+			counts[26]++;
+			total_letters++;
+		} else if (c == '\n' || c == '\r' || c == '\t' ||
+		    c == ',' || c == '.' || c == '\'' || c == '"') {
+		} else if (c < 32 || c > 126) {
+			penalty += 50.0;
+		}
+	}
+
+	if (total_letters == 0) {
+		return -1000.0 - penalty;
+	}
+	double chi2 = 0.0;
+	for (int i = 0; i < 27; i++) {
+		double expected = freq[i] * (double) total_letters;
+		double diff = (double) counts[i] - expected;
+		chi2 += (diff * diff) / (expected + 1e-9);
+	}
+	return -chi2 + 50.0 * (double) total_letters / (double) len - penalty;
+}
+
+typedef struct
+{
+	const uint8_t *bytes;
+	const char *hex;
+	size_t len;		/**< Bytes per call. */
+	uint8_t *plain;
+	utils_hex_view *views;
+	utils_xor_result *results;
+	uint64_t *hist;
+	volatile double sink;
+} score_case;
+
+static void
+run_reference(void *arg)
+{
+	score_case *c = arg;
+	c->sink += score_reference(c->bytes, c->len);
+}
+
+static void
+run_bytes(void *arg)
+{
+	score_case *c = arg;
+	double score = 0.0;
+	score_english_bytes(c->bytes, c->len, &score);
+	c->sink += score;
+}
+
+static void
+run_hex(void *arg)
+{
+	score_case *c = arg;
+	double score = 0.0;
+	score_english_hex_n(c->hex, 2 * c->len, &score);
+	c->sink += score;
+}
+
+static void
+run_brute_force(void *arg)
+{
+	score_case *c = arg;
+	size_t len = 0;
+	uint8_t key = 0;
+	brute_force_single_byte_xor_n(c->hex, 2 * c->len, c->plain,
+	    BENCH_MAX_LEN, &len, &key, NULL);
+	c->sink += key;
+}
+
+static void
+run_rank_all(void *arg)
+{
+	score_case *c = arg;
+	uint8_t values[256];
+	uint64_t counts[256];
+	size_t distinct = 0;
+	for (int b = 0; b < 256; ++b) {
+		if (c->hist[b] != 0) {
+			values[distinct] = (uint8_t) b;
+			counts[distinct++] = c->hist[b];
+		}
+	}
+
+	// Unpruned baseline: score every key over all distinct bytes, as
+	// brute_force_single_byte_xor_histogram() does, keeping the best five.
+	utils_key_score top[5];
+	size_t count = 0;
+	for (int key = 0; key < 256; ++key) {
+		utils_key_score cand = { (uint8_t) key, 0.0 };
+		score_english_distinct(values, counts, distinct, (uint8_t) key,
+		    &cand.score);
+		size_t pos = count < 5 ? count++ : 5;
+		while (pos > 0 && cand.score > top[pos - 1].score) {
+			if (pos < 5) {
+				top[pos] = top[pos - 1];
+			}
+			--pos;
+		}
+		if (pos < 5) {
+			top[pos] = cand;
+		}
+	}
+	c->sink += top[0].key;
+}
+
+static void
+run_top_k(void *arg)
+{
+	score_case *c = arg;
+	utils_key_score top[5];
+	size_t count = 0;
+	brute_force_single_byte_xor_top_k(c->hist, 5, top, &count, NULL);
+	c->sink += top[0].key;
+}
+
+static void
+run_batch(void *arg)
+{
+	score_case *c = arg;
+	brute_force_single_byte_xor_batch(c->views, BENCH_LINES, c->plain,
+	    BENCH_MAX_LEN, c->results);
+	c->sink += c->results[0].key;
+}
+
+int
+main(int argc, char **argv)
+{
+	static const char english[] =
+	    "It was the best of times, it was the worst of times, it was "
+	    "the age of wisdom, it was the age of foolishness.\n";
+	static const size_t sizes[] = { 64, 4096, BENCH_MAX_LEN };
+
+	bench_config cfg;
+	if (bench_init(&cfg, "score_english", argc, argv) < 0) {
+		return EXIT_FAILURE;
+	}
+
+	uint8_t *random_bytes = malloc(BENCH_MAX_LEN);
+	uint8_t *english_bytes = malloc(BENCH_MAX_LEN);
+	char *random_hex = malloc(2 * BENCH_MAX_LEN + 1);
+	char *english_hex = malloc(2 * BENCH_MAX_LEN + 1);
+	uint8_t *plain = malloc(BENCH_MAX_LEN);
+	utils_hex_view *views = malloc(BENCH_LINES * sizeof(*views));
+	utils_xor_result *results = malloc(BENCH_LINES * sizeof(*results));
+	uint64_t hist[256];
+	if (!random_bytes || !english_bytes || !random_hex || !english_hex ||
+	    !plain || !views || !results) {
+		fprintf(stderr, "bench_score_english: out of memory\n");
+		free(random_bytes);
+		free(english_bytes);
+		free(random_hex);
+		free(english_hex);
+		free(plain);
+		free(views);
+		free(results);
+		return EXIT_FAILURE;
+	}
+
+	uint32_t state = 0x9E3779B9u;
+	for (size_t i = 0; i < BENCH_MAX_LEN; ++i) {
+		state = state * 1103515245u + 12345u;
+		random_bytes[i] = (uint8_t) (state >> 24);
+		english_bytes[i] = (uint8_t) english[i % (sizeof(english) - 1)];
+	}
+	bytes_to_hex(random_bytes, BENCH_MAX_LEN, random_hex,
+	    2 * BENCH_MAX_LEN + 1);
+	// The solver inputs are English under key 0x35.
+	for (size_t i = 0; i < BENCH_MAX_LEN; ++i) {
+		plain[i] = english_bytes[i] ^ 0x35;
+	}
+	bytes_to_hex(plain, BENCH_MAX_LEN, english_hex, 2 * BENCH_MAX_LEN + 1);
+	for (size_t i = 0; i < BENCH_LINES; ++i) {
+		views[i].hex = random_hex + 2 * BENCH_LINE_BYTES * i;
+		views[i].len = 2 * BENCH_LINE_BYTES;
+	}
+
+	score_case inputs[2] = {
+		{ random_bytes, random_hex, 0, plain, views, results, hist,
+		    0.0 },
+		{ english_bytes, english_hex, 0, plain, views, results, hist,
+		    0.0 }
+	};
+	static const char *const input_names[2] = { "random", "english" };
+
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+		for (size_t in = 0; in < 2; ++in) {
+			score_case *c = &inputs[in];
+			c->len = sizes[s];
+			bench_run(&cfg, "score_reference", input_names[in],
+			    c->len, run_reference, c);
+			bench_run(&cfg, "score_english_bytes", input_names[in],
+			    c->len, run_bytes, c);
+			bench_run(&cfg, "score_english_hex", input_names[in],
+			    c->len, run_hex, c);
+		}
+	}
+
+	static const size_t line_sizes[] = { BENCH_LINE_BYTES, 4096,
+		BENCH_MAX_LEN };
+	score_case *c = &inputs[1];
+	for (size_t s = 0; s < sizeof(line_sizes) / sizeof(line_sizes[0]);
+	    ++s) {
+		c->len = line_sizes[s];
+		bench_run(&cfg, "brute_force_xor", "english", c->len,
+		    run_brute_force, c);
+	}
+	// Ranking works on the histogram, so its cost tracks the number of
+	// distinct bytes rather than the length; one line is representative.
+	for (size_t i = 0; i < BENCH_LINE_BYTES; ++i) {
+		plain[i] = english_bytes[i] ^ 0x35;
+	}
+	utils_byte_histogram(plain, BENCH_LINE_BYTES, hist);
+	bench_run(&cfg, "rank_keys_all", "english", BENCH_LINE_BYTES,
+	    run_rank_all, c);
+	bench_run(&cfg, "rank_keys_top5", "english", BENCH_LINE_BYTES,
+	    run_top_k, c);
+	bench_run(&cfg, "brute_force_xor_batch", "327x30",
+	    BENCH_LINES * BENCH_LINE_BYTES, run_batch, c);
+
+	free(random_bytes);
+	free(english_bytes);
+	free(random_hex);
+	free(english_hex);
+	free(plain);
+	free(views);
+	free(results);
+	return EXIT_SUCCESS;
+}
@@ -9,6 +9,7 @@
 #include <string.h>
 
 #include "hex2b64.h"
+#include "stats.h"
 
 /**
  * @brief Convert the fixed challenge hex string and compare to expected Base64.
@@ -18,6 +19,8 @@
 int
 main(void)
 {
+	stats_dump_at_exit();
+
 	const char hex_input[] =
 	    "49276d206b696c6c696e6720796f757220627261696e206c696b65206120706f69736f"
 	    "6e6f7573206d757368726f6f6d";
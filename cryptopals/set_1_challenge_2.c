@@ -9,11 +9,14 @@
 #include <string.h>
 
 #include "fixed_xor.h"
+#include "stats.h"
 #include "utils.h"
 
 int
 main(void)
 {
+	stats_dump_at_exit();
+
 	const char lhs_hex[] = "1c0111001f010100061a024b53535009181c";
 	const char rhs_hex[] = "686974207468652062756c6c277320657965";
 	const char expected_hex[] = "746865206b696420646f6e277420706c6179";
@@ -8,11 +8,14 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "stats.h"
 #include "utils.h"
 
 int
 main(void)
 {
+	stats_dump_at_exit();
+
 	const char hex_input[] =
 	    "1b37373331363f78151b7f2b783431333d78397828372d363c78373e783a393b3736";
 
@@ -8,16 +8,14 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "fixed_xor.h"
+#include "repeat_xor.h"
+#include "stats.h"
 #include "utils.h"
 
 static void
-free_buffers(uint8_t *plaintext,
-    uint8_t *key_stream, uint8_t *cipher, char *cipher_hex)
+free_buffers(uint8_t *buffer, char *cipher_hex)
 {
-	free(plaintext);
-	free(key_stream);
-	free(cipher);
+	free(buffer);
 	free(cipher_hex);
 }
 
@@ -67,6 +65,8 @@ read_file_into_buffer(const char *path, uint8_t **out_buf, size_t *out_len)
 int
 main(void)
 {
+	stats_dump_at_exit();
+
 	const char path[] = "assets/5.txt";
 	uint8_t *plaintext = NULL;
 	size_t plaintext_len = 0;
@@ -83,39 +83,29 @@ main(void)
 	}
 
 	const char key[] = "ICE";
-	uint8_t *key_stream = malloc(plaintext_len);
-	uint8_t *cipher = malloc(plaintext_len);
 	char *cipher_hex = malloc(plaintext_len * 2 + 1);
-	if (!key_stream || !cipher || !cipher_hex) {
+	if (!cipher_hex) {
 		fprintf(stderr, "Allocation failure\n");
-		free_buffers(plaintext, key_stream, cipher, cipher_hex);
-		return EXIT_FAILURE;
-	}
-
-	utils_status ustatus =
-	    utils_repeat_key(key, key_stream, plaintext_len);
-	if (ustatus != UTILS_OK) {
-		fprintf(stderr, "utils_repeat_key failed: %s\n",
-		    utils_status_string(ustatus));
-		free_buffers(plaintext, key_stream, cipher, cipher_hex);
+		free_buffers(plaintext, cipher_hex);
 		return EXIT_FAILURE;
 	}
 
-	fixed_xor_status fx_status =
-	    fixed_xor_buffers(plaintext, key_stream, cipher, plaintext_len);
-	if (fx_status != FIXED_XOR_OK) {
-		fprintf(stderr, "fixed_xor_buffers failed: %s\n",
-		    fixed_xor_status_string(fx_status));
-		free_buffers(plaintext, key_stream, cipher, cipher_hex);
+	// Encrypt in place; no key stream the size of the input is built.
+	repeat_xor_status rx_status = repeating_key_xor(plaintext, plaintext,
+	    plaintext_len, (const uint8_t *) key, strlen(key));
+	if (rx_status != REPEAT_XOR_OK) {
+		fprintf(stderr, "repeating_key_xor failed: %s\n",
+		    repeat_xor_status_string(rx_status));
+		free_buffers(plaintext, cipher_hex);
 		return EXIT_FAILURE;
 	}
 
-	ustatus = bytes_to_hex(cipher,
+	utils_status ustatus = bytes_to_hex(plaintext,
 	    plaintext_len, cipher_hex, plaintext_len * 2 + 1);
 	if (ustatus != UTILS_OK) {
 		fprintf(stderr, "bytes_to_hex failed: %s\n",
 		    utils_status_string(ustatus));
-		free_buffers(plaintext, key_stream, cipher, cipher_hex);
+		free_buffers(plaintext, cipher_hex);
 		return EXIT_FAILURE;
 	}
 
@@ -130,10 +120,10 @@ main(void)
 	} else {
 		printf("FAIL: expected\n%s\nbut got\n%s\n", expected_hex,
 		    cipher_hex);
-		free_buffers(plaintext, key_stream, cipher, cipher_hex);
+		free_buffers(plaintext, cipher_hex);
 		return EXIT_FAILURE;
 	}
 
-	free_buffers(plaintext, key_stream, cipher, cipher_hex);
+	free_buffers(plaintext, cipher_hex);
 	return EXIT_SUCCESS;
 }
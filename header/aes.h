@@ -0,0 +1,79 @@
+#ifndef AES_H
+#define AES_H
+
+/**
+ * @file aes.h
+ * @brief Public interface for the AES-128 block cipher.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief AES block size in bytes. */
+#define AES_BLOCK_SIZE 16
+
+/** @brief AES-128 key size in bytes. */
+#define AES128_KEY_SIZE 16
+
+/** @brief Number of AES-128 rounds. */
+#define AES128_ROUNDS 10
+
+/**
+ * @brief Status codes describing the outcome of AES operations.
+ */
+typedef enum
+{
+	AES_OK = 0,
+	AES_ERR_ARGS = -1,
+	AES_ERR_LENGTH = -2	/**< Length is not a multiple of the block. */
+} aes_status;
+
+/**
+ * @brief Expanded AES-128 key.
+ *
+ * Round keys are kept as bytes in FIPS-197 order. @c dec holds the
+ * equivalent inverse cipher schedule: the encryption round keys reversed,
+ * with InvMixColumns applied to the inner nine.
+ */
+typedef struct
+{
+	uint8_t enc[AES128_ROUNDS + 1][AES_BLOCK_SIZE];
+	uint8_t dec[AES128_ROUNDS + 1][AES_BLOCK_SIZE];
+} aes128_key;
+
+/**
+ * @brief Expand @p key into both round key schedules.
+ *
+ * Do this once per key; the schedule can then be shared read-only between
+ * threads.
+ */
+aes_status aes128_expand_key(aes128_key * ks,
+    const uint8_t key[AES128_KEY_SIZE]);
+
+/**
+ * @brief Encrypt @p len bytes in ECB mode.
+ *
+ * Uses AES-NI with eight blocks in flight when the CPU supports it, and
+ * portable lookup tables otherwise. Works in place when @p out equals @p in.
+ *
+ * @param ks  Expanded key.
+ * @param in  Plaintext (may be NULL when @p len is 0).
+ * @param out Ciphertext buffer of @p len bytes.
+ * @param len Byte count; must be a multiple of AES_BLOCK_SIZE.
+ * @return AES_OK on success or an error status on failure.
+ */
+aes_status aes128_ecb_encrypt(const aes128_key * ks, const uint8_t * in,
+    uint8_t * out, size_t len);
+
+/**
+ * @brief Decrypt @p len bytes in ECB mode; see aes128_ecb_encrypt().
+ */
+aes_status aes128_ecb_decrypt(const aes128_key * ks, const uint8_t * in,
+    uint8_t * out, size_t len);
+
+/**
+ * @brief Convert an aes_status value into a human-readable string.
+ */
+const char *aes_status_string(aes_status status);
+
+#endif /* AES_H */
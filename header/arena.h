@@ -0,0 +1,100 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+/**
+ * @file arena.h
+ * @brief Bump allocator and per-thread scratch arenas for library hot paths.
+ */
+
+#include <stddef.h>
+
+/** @brief Largest alignment arena_alloc() honours; block data starts here. */
+#define ARENA_MAX_ALIGN 64
+
+/** @brief Smallest block requested from malloc(). */
+#define ARENA_MIN_BLOCK (64u * 1024u)
+
+typedef struct arena_block arena_block;
+
+/**
+ * @brief A stack of malloc()ed blocks carved up by bumping an offset.
+ *
+ * Blocks handed back by arena_restore() are kept on a spare list and reused
+ * before anything new is allocated, so a routine that allocates the same
+ * way on every call stops touching the heap after its first call.
+ */
+typedef struct
+{
+	arena_block *head;	/**< Block currently bumped; NULL when empty. */
+	arena_block *spare;	/**< Released blocks waiting for reuse. */
+} arena;
+
+/**
+ * @brief A position in an arena to roll back to.
+ */
+typedef struct
+{
+	arena_block *block;
+	size_t used;
+} arena_mark;
+
+/** @brief Static initializer for an empty arena. */
+#define ARENA_INIT { NULL, NULL }
+
+void arena_init(arena * a);
+
+/**
+ * @brief Carve @p size bytes aligned to @p align out of @p a.
+ *
+ * @param a     Arena to allocate from.
+ * @param size  Bytes requested; 0 yields a pointer that must not be read.
+ * @param align Power of two no larger than ARENA_MAX_ALIGN; 0 means 1.
+ * @return The memory, or NULL on bad arguments or allocation failure.
+ */
+void *arena_alloc(arena * a, size_t size, size_t align);
+
+/**
+ * @brief arena_alloc() for @p count zeroed elements of @p size bytes,
+ * aligned for any standard type.
+ */
+void *arena_calloc(arena * a, size_t count, size_t size);
+
+/** @brief Remember the current allocation point of @p a. */
+arena_mark arena_save(const arena * a);
+
+/**
+ * @brief Free everything allocated since @p mark was taken.
+ *
+ * Memory is not returned to the system; emptied blocks move to the spare
+ * list. Marks must be restored in reverse order of arena_save().
+ */
+void arena_restore(arena * a, arena_mark mark);
+
+/** @brief arena_restore() to the empty arena. */
+void arena_reset(arena * a);
+
+/** @brief Return every block, including spares, to the system. */
+void arena_release(arena * a);
+
+/**
+ * @brief The calling thread's scratch arena, created on first use.
+ *
+ * Library routines that need temporary memory take it from here between an
+ * arena_save() and an arena_restore(), so nested calls share one arena and
+ * repeated calls reuse the same blocks. The arena is released when the
+ * thread exits.
+ *
+ * @return The arena, or NULL if it could not be created.
+ */
+arena *arena_scratch(void);
+
+/**
+ * @brief Number of blocks every arena in the process has taken from
+ * malloc() so far.
+ *
+ * Test helper: a warmed-up routine that reuses its scratch blocks leaves
+ * the count unchanged.
+ */
+size_t arena_heap_blocks(void);
+
+#endif /* ARENA_H */
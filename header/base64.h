@@ -0,0 +1,61 @@
+#ifndef BASE64_H
+#define BASE64_H
+
+/**
+ * @file base64.h
+ * @brief Public interface for decoding Base64 text into raw bytes.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief Error states for Base64 decoding.
+ */
+typedef enum
+{
+	BASE64_OK = 0,
+	BASE64_ERR_ARGS = -1,
+	BASE64_ERR_INVALID_CHAR = -2,	/**< Byte outside the alphabet. */
+	BASE64_ERR_BAD_PADDING = -3,	/**< Misplaced '=' or data after it. */
+	BASE64_ERR_TRUNCATED = -4,	/**< Input ended inside a group. */
+	BASE64_ERR_OUTPUT_OVERFLOW = -5,
+	BASE64_ERR_IO = -6
+} base64_status;
+
+/**
+ * @brief Decode a Base64 buffer.
+ *
+ * ASCII whitespace (including newlines) may appear anywhere and is
+ * ignored. Every group must be complete; the final group may carry one or
+ * two '=' padding characters and only whitespace may follow it.
+ *
+ * @param in         Base64 text (may be NULL when @p in_len is 0).
+ * @param in_len     Number of characters in @p in.
+ * @param out        Destination buffer for decoded bytes.
+ * @param out_cap    Capacity of @p out in bytes.
+ * @param out_len    Optional pointer that receives the bytes produced.
+ * @param err_offset Optional pointer that receives the offset into @p in
+ *                   of the offending character when decoding fails; for
+ *                   BASE64_ERR_TRUNCATED it is @p in_len.
+ */
+base64_status base64_to_bytes(const uint8_t * in, size_t in_len,
+    uint8_t * out, size_t out_cap, size_t *out_len, size_t *err_offset);
+
+/**
+ * @brief Decode Base64 text read from a stream.
+ *
+ * Accepts the same syntax as base64_to_bytes(); offsets are counted from
+ * the first byte read from @p in.
+ *
+ * @param in         Input stream providing Base64 text.
+ * @param out        Output stream that receives the decoded bytes.
+ * @param err_offset Optional pointer that receives the error offset.
+ */
+base64_status base64_decode_stream(FILE * in, FILE * out,
+    size_t *err_offset);
+
+const char *base64_status_string(base64_status status);
+
+#endif /* BASE64_H */
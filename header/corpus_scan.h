@@ -0,0 +1,98 @@
+#ifndef CORPUS_SCAN_H
+#define CORPUS_SCAN_H
+
+/**
+ * @file corpus_scan.h
+ * @brief Pieces shared by the multithreaded line scanners: a bounded
+ * top-N heap, worker launch and line numbering of corpus results.
+ *
+ * Internal to the library; xor_scan and ecb_detect are built on it.
+ */
+
+#include <pthread.h>
+#include <stddef.h>
+
+#include "hex_corpus.h"
+
+/**
+ * @brief Return non-zero when the element at @p a ranks below @p b.
+ *
+ * Must be a strict total order so results do not depend on the order in
+ * which workers finish.
+ */
+typedef int (*corpus_scan_worse_fn)(const void *a, const void *b);
+
+/**
+ * @brief Bounded min-heap holding the best elements seen so far.
+ *
+ * The root is the weakest kept element, so a new candidate only has to
+ * beat the root to get in.
+ */
+typedef struct
+{
+	void *items;		/**< Storage for @c cap elements. */
+	size_t len;		/**< Elements currently kept. */
+	size_t cap;		/**< Most elements kept. */
+	size_t size;		/**< Bytes per element. */
+	corpus_scan_worse_fn worse;
+} corpus_scan_heap;
+
+/**
+ * @brief Set up an empty heap over caller-provided storage.
+ *
+ * @param heap  Heap to initialize.
+ * @param items Storage for @p cap elements of @p size bytes.
+ * @param cap   Number of elements to keep.
+ * @param size  Bytes per element.
+ * @param worse Ranking of two elements.
+ */
+void corpus_scan_heap_init(corpus_scan_heap * heap, void *items, size_t cap,
+    size_t size, corpus_scan_worse_fn worse);
+
+/** @brief Offer @p item to @p heap; it is copied in if it ranks high enough. */
+void corpus_scan_heap_push(corpus_scan_heap * heap, const void *item);
+
+/** @brief Offer every element of @p from to @p into. */
+void corpus_scan_heap_merge(corpus_scan_heap * into,
+    const corpus_scan_heap * from);
+
+/**
+ * @brief Sort the kept elements best first, in place.
+ *
+ * The heap order is lost; push nothing afterwards.
+ */
+void corpus_scan_heap_sort(corpus_scan_heap * heap);
+
+/**
+ * @brief Fill in line numbers for elements that came from @p corpus.
+ *
+ * Workers only know where a line starts, not how many lines precede it, so
+ * the numbers are recovered with one newline pass once the final top-N is
+ * known. Elements are left in corpus order; call corpus_scan_heap_sort()
+ * afterwards.
+ *
+ * @param heap        Elements to number.
+ * @param corpus      Corpus the elements point into.
+ * @param hex_offset  offsetof() the element's <tt>const char *</tt> line start.
+ * @param line_offset offsetof() the element's @c size_t line number.
+ */
+void corpus_scan_number_lines(corpus_scan_heap * heap,
+    const hex_corpus * corpus, size_t hex_offset, size_t line_offset);
+
+/**
+ * @brief Run @p fn on each of @p threads workers and wait for all of them.
+ *
+ * Worker 0 runs on the calling thread; the rest get their own. If a thread
+ * cannot be started, the workers already started are still joined.
+ *
+ * @param workers Array of @p threads worker structs of @p stride bytes.
+ * @param stride  Bytes per worker struct.
+ * @param threads Number of workers; at least 1.
+ * @param tids    Storage for @p threads thread handles.
+ * @param fn      Worker body, called with a pointer to its struct.
+ * @return 0 on success, -1 when a thread could not be started.
+ */
+int corpus_scan_run_workers(void *workers, size_t stride, size_t threads,
+    pthread_t * tids, void *(*fn)(void *));
+
+#endif /* CORPUS_SCAN_H */
@@ -0,0 +1,56 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+/**
+ * @file cpu_features.h
+ * @brief Runtime CPU feature detection used to dispatch SIMD kernels.
+ */
+
+/**
+ * @brief Non-zero when x86 SIMD kernels can be compiled with per-function
+ * target attributes and selected at runtime.
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CPU_FEATURES_X86 1
+#else
+#define CPU_FEATURES_X86 0
+#endif
+
+/**
+ * @brief Instruction set extensions a kernel may require.
+ */
+typedef enum
+{
+	CPU_FEATURE_SSE2 = 1u << 0,
+	CPU_FEATURE_SSSE3 = 1u << 1,
+	CPU_FEATURE_AVX2 = 1u << 2,
+	CPU_FEATURE_AVX512F = 1u << 3,
+	CPU_FEATURE_POPCNT = 1u << 4,
+	CPU_FEATURE_AVX512VPOPCNTDQ = 1u << 5,
+	CPU_FEATURE_AESNI = 1u << 6
+} cpu_feature;
+
+/**
+ * @brief Return the bitmask of usable features on this CPU.
+ *
+ * The result is the detected set restricted by cpu_features_set_mask().
+ */
+unsigned cpu_features(void);
+
+/**
+ * @brief Return non-zero when every bit of @p features is usable.
+ */
+int cpu_has(unsigned features);
+
+/**
+ * @brief Test helper to restrict which detected features may be used.
+ *
+ * Passing 0 forces every dispatcher onto its portable scalar path; passing
+ * ~0u restores full detection. Not thread-safe: call it while no other
+ * thread is inside the library.
+ *
+ * @param mask Features that dispatchers are allowed to use.
+ */
+void cpu_features_set_mask(unsigned mask);
+
+#endif /* CPU_FEATURES_H */
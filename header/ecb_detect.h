@@ -0,0 +1,77 @@
+#ifndef ECB_DETECT_H
+#define ECB_DETECT_H
+
+/**
+ * @file ecb_detect.h
+ * @brief ECB-mode detection by counting repeated 16-byte blocks.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hex_corpus.h"
+
+/** @brief Block size compared by the detector, in bytes. */
+#define ECB_DETECT_BLOCK 16
+
+typedef enum
+{
+	ECB_DETECT_OK = 0,
+	ECB_DETECT_ERR_ARGS = -1,
+	ECB_DETECT_ERR_OOM = -2,
+	ECB_DETECT_ERR_THREAD = -3
+} ecb_detect_status;
+
+/**
+ * @brief One ranked line and how many of its blocks repeat.
+ */
+typedef struct
+{
+	size_t line;		/**< Zero-based index of the line. */
+	const char *hex;	/**< The line itself (not NUL-terminated). */
+	size_t hex_len;		/**< Length of @c hex in characters. */
+	size_t blocks;		/**< Whole 16-byte blocks in the line. */
+	size_t repeats;		/**< Blocks equal to an earlier block. */
+} ecb_detect_result;
+
+/**
+ * @brief Count the 16-byte blocks of @p bytes that repeat an earlier block.
+ *
+ * A trailing partial block is ignored. Allocates a hash set per call; use
+ * ecb_detect_corpus() for bulk scans.
+ *
+ * @param bytes   Ciphertext (may be NULL when @p len is 0).
+ * @param len     Ciphertext length in bytes.
+ * @param repeats Receives the number of repeated blocks.
+ */
+ecb_detect_status ecb_detect_count_repeats(const uint8_t * bytes, size_t len,
+    size_t *repeats);
+
+/**
+ * @brief Rank every non-blank line of a hex corpus by repeated blocks.
+ *
+ * Workers take contiguous byte ranges of the corpus, as in
+ * xor_scan_corpus(). Each decodes lines into a buffer and inserts their
+ * blocks into an open-addressing hash set; both are reused for every line
+ * and only grow when a line is longer than any before it. Set slots carry a
+ * generation tag, so starting a new line is a counter increment rather than
+ * a clear.
+ *
+ * Results are ordered by descending repeat count; equal counts keep the
+ * lower line first, independent of the thread count. Lines that are not
+ * valid hex are skipped.
+ *
+ * @param corpus  Corpus to scan.
+ * @param threads Worker count; 0 selects one per online CPU.
+ * @param top     Destination for the best results.
+ * @param top_cap Capacity of @p top (the N in top-N); must be non-zero.
+ * @param top_len Receives the number of results written.
+ * @param skipped Optional pointer that receives the number of skipped lines.
+ */
+ecb_detect_status ecb_detect_corpus(const hex_corpus * corpus,
+    size_t threads, ecb_detect_result * top, size_t top_cap,
+    size_t *top_len, size_t *skipped);
+
+const char *ecb_detect_status_string(ecb_detect_status status);
+
+#endif /* ECB_DETECT_H */
@@ -20,12 +20,18 @@ typedef enum
 	FIXED_XOR_ERR_IO = -2,	  /**< I/O failure while reading or writing. */
 	FIXED_XOR_ERR_ODD_INPUT = -3,
 				  /**< Stream input contained an odd byte count. */
-	FIXED_XOR_ERR_OOM = -4	  /**< Memory allocation failed. */
+	FIXED_XOR_ERR_OOM = -4,	  /**< Memory allocation failed. */
+	FIXED_XOR_ERR_LENGTH_MISMATCH = -5
+				  /**< Paired inputs differ in length. */
 } fixed_xor_status;
 
 /**
  * @brief XOR two buffers of equal length into an output buffer.
  *
+ * Uses the widest SIMD kernel the CPU supports. @p out may be the same
+ * pointer as @p lhs or @p rhs for in-place operation; any other overlap is
+ * undefined.
+ *
  * @param lhs Pointer to the left-hand buffer.
  * @param rhs Pointer to the right-hand buffer.
  * @param out Destination buffer that receives lhs ^ rhs.
@@ -41,12 +47,30 @@ fixed_xor_status fixed_xor_buffers(const uint8_t * lhs,
  * The input stream is expected to contain two equally sized buffers back to
  * back. The result is written to @p out.
  *
+ * When @p in is a regular file its remaining size is known up front, so both
+ * halves are read in place with pread() and XORed block by block in constant
+ * memory. Pipes and terminals fall back to buffering the whole input.
+ *
  * @param in  Stream containing the concatenated buffers.
  * @param out Stream that receives XOR output.
  * @return FIXED_XOR_OK on success or an error status on failure.
  */
 fixed_xor_status fixed_xor_stream(FILE * in, FILE * out);
 
+/**
+ * @brief XOR two separate streams block by block in constant memory.
+ *
+ * Output is written as soon as each block of both inputs is available. If
+ * one input ends before the other, FIXED_XOR_ERR_LENGTH_MISMATCH is returned
+ * after the common prefix has been written.
+ *
+ * @param lhs Stream supplying the left-hand buffer.
+ * @param rhs Stream supplying the right-hand buffer.
+ * @param out Stream that receives XOR output.
+ * @return FIXED_XOR_OK on success or an error status on failure.
+ */
+fixed_xor_status fixed_xor_stream_pair(FILE * lhs, FILE * rhs, FILE * out);
+
 /**
  * @brief Convert a fixed_xor_status value into a human-readable string.
  *
@@ -58,6 +82,9 @@ const char *fixed_xor_status_string(fixed_xor_status status);
 /**
  * @brief Test helper to force allocation failures during stream processing.
  *
+ * Only the buffer that fixed_xor_stream() grows for non-seekable input
+ * honours the flag; regular files are split with pread() and never grow.
+ *
  * @param enable Non-zero to simulate an allocation failure.
  */
 void fixed_xor_set_allocation_failure(int enable);
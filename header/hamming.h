@@ -0,0 +1,58 @@
+#ifndef HAMMING_H
+#define HAMMING_H
+
+/**
+ * @file hamming.h
+ * @brief Public interface for bitwise Hamming distance.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Status codes describing the outcome of Hamming distance operations.
+ */
+typedef enum
+{
+	HAMMING_OK = 0,
+	HAMMING_ERR_ARGS = -1
+} hamming_status;
+
+/**
+ * @brief Count the bits that differ between two buffers.
+ *
+ * Dispatches at runtime to AVX-512 VPOPCNTQ, an AVX2 Harley-Seal kernel,
+ * hardware POPCNT or a portable 64-bit loop.
+ *
+ * @param a        First buffer (may be NULL when @p len is 0).
+ * @param b        Second buffer (may be NULL when @p len is 0).
+ * @param len      Number of bytes to compare.
+ * @param out_bits Receives the number of differing bits.
+ * @return HAMMING_OK on success or an error status on failure.
+ */
+hamming_status hamming_distance(const uint8_t * a, const uint8_t * b,
+    size_t len, uint64_t * out_bits);
+
+/**
+ * @brief Hamming distance from one query to each of @p count buffers.
+ *
+ * Equivalent to calling hamming_distance() once per item, but the kernel is
+ * chosen once for the whole batch.
+ *
+ * @param query    Buffer compared against every item.
+ * @param items    Array of @p count buffers, each @p len bytes long.
+ * @param count    Number of items.
+ * @param len      Bytes per buffer.
+ * @param out_bits Receives @p count distances, in item order.
+ * @return HAMMING_OK on success or an error status on failure.
+ */
+hamming_status hamming_distance_batch(const uint8_t * query,
+    const uint8_t * const *items, size_t count, size_t len,
+    uint64_t * out_bits);
+
+/**
+ * @brief Convert a hamming_status value into a human-readable string.
+ */
+const char *hamming_status_string(hamming_status status);
+
+#endif /* HAMMING_H */
@@ -20,12 +20,16 @@ typedef enum
 	HEX2B64_ERR_INVALID_HEX = -2,
 	HEX2B64_ERR_ODD_DIGITS = -3,
 	HEX2B64_ERR_OUTPUT_OVERFLOW = -4,
-	HEX2B64_ERR_IO = -5
+	HEX2B64_ERR_IO = -5,
+	HEX2B64_ERR_OOM = -6
 } hex2b64_status;
 
 /**
  * @brief Convert hexadecimal text read from a stream into Base64.
  *
+ * Whitespace between digits is ignored. On an invalid digit the Base64 of
+ * every complete 3-byte group before it has already been written.
+ *
  * @param in  Input stream providing ASCII hex characters.
  * @param out Output stream that receives Base64 data.
  */
@@ -34,6 +38,10 @@ hex2b64_status hex2b64_stream(FILE * in, FILE * out);
 /**
  * @brief Convert a memory buffer of hexadecimal characters into Base64.
  *
+ * Errors are reported in input order: when @p out fills up before an
+ * invalid digit is reached the result is HEX2B64_ERR_OUTPUT_OVERFLOW, and
+ * @p out holds every whole group that fitted.
+ *
  * @param hex      Pointer to the hex buffer (may be NULL when @p hex_len is 0).
  * @param hex_len  Number of bytes in @p hex.
  * @param out      Destination buffer for Base64 characters.
@@ -43,6 +51,20 @@ hex2b64_status hex2b64_stream(FILE * in, FILE * out);
 hex2b64_status hex2b64_buffer(const uint8_t * hex,
     size_t hex_len, uint8_t * out, size_t out_cap, size_t *out_len);
 
+/**
+ * @brief Base64-encode raw bytes, skipping the hex stage entirely.
+ *
+ * Output is padded with '=' and is not newline- or NUL-terminated.
+ *
+ * @param bytes    Input bytes (may be NULL when @p len is 0).
+ * @param len      Number of input bytes.
+ * @param out      Destination for 4 * ceil(@p len / 3) Base64 characters.
+ * @param out_cap  Capacity of @p out in bytes.
+ * @param out_len  Optional pointer that receives the characters produced.
+ */
+hex2b64_status bytes_to_base64(const uint8_t * bytes, size_t len,
+    uint8_t * out, size_t out_cap, size_t *out_len);
+
 const char *hex2b64_status_string(hex2b64_status status);
 
 #endif /* HEX2B64_H */
@@ -0,0 +1,85 @@
+#ifndef HEX_CORPUS_H
+#define HEX_CORPUS_H
+
+/**
+ * @file hex_corpus.h
+ * @brief Zero-copy, memory-mapped access to line-oriented hex corpora.
+ */
+
+#include <stddef.h>
+
+typedef enum
+{
+	HEX_CORPUS_OK = 0,
+	HEX_CORPUS_ERR_ARGS = -1,
+	HEX_CORPUS_ERR_IO = -2
+} hex_corpus_status;
+
+/**
+ * @brief A corpus held in memory, usually a read-only file mapping.
+ */
+typedef struct
+{
+	const char *data;	/**< First byte of the corpus. */
+	size_t size;		/**< Corpus length in bytes. */
+	int mapped;		/**< Non-zero when @c data must be munmap()ed. */
+} hex_corpus;
+
+/**
+ * @brief A view of one line inside a corpus; it is not NUL-terminated.
+ */
+typedef struct
+{
+	const char *data;	/**< First character of the line. */
+	size_t len;		/**< Length without the line terminator. */
+} hex_corpus_line;
+
+/**
+ * @brief Iterator over the lines that start inside a byte range.
+ */
+typedef struct
+{
+	const char *pos;	/**< Next unread byte. */
+	const char *stop;	/**< Lines starting at or after this are excluded. */
+	const char *end;	/**< End of the corpus. */
+} hex_corpus_cursor;
+
+/**
+ * @brief Map @p path read-only. Memory use does not grow with file size.
+ */
+hex_corpus_status hex_corpus_open(const char *path, hex_corpus * corpus);
+
+/**
+ * @brief Wrap an existing buffer as a corpus without copying it.
+ */
+hex_corpus_status hex_corpus_from_buffer(const char *data, size_t size,
+    hex_corpus * corpus);
+
+/**
+ * @brief Release a corpus obtained from hex_corpus_open().
+ */
+void hex_corpus_close(hex_corpus * corpus);
+
+/**
+ * @brief Position @p cursor on shard @p index of @p count.
+ *
+ * The corpus is split into @p count byte ranges of roughly equal size; a
+ * line belongs to the shard its first byte falls in, so every line is
+ * visited by exactly one shard. Shard 0 of 1 covers the whole corpus.
+ */
+void hex_corpus_shard(const hex_corpus * corpus, size_t index, size_t count,
+    hex_corpus_cursor * cursor);
+
+/**
+ * @brief Advance @p cursor to the next non-blank line.
+ *
+ * Trailing "\n" or "\r\n" is stripped from the view; blank lines are
+ * skipped.
+ *
+ * @return 1 when @p line was filled, 0 at the end of the shard.
+ */
+int hex_corpus_next(hex_corpus_cursor * cursor, hex_corpus_line * line);
+
+const char *hex_corpus_status_string(hex_corpus_status status);
+
+#endif /* HEX_CORPUS_H */
@@ -0,0 +1,127 @@
+#ifndef REPEAT_XOR_H
+#define REPEAT_XOR_H
+
+/**
+ * @file repeat_xor.h
+ * @brief Public interface for repeating-key XOR.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Status codes describing the outcome of repeating-key XOR operations.
+ */
+typedef enum
+{
+	REPEAT_XOR_OK = 0,
+	REPEAT_XOR_ERR_ARGS = -1,
+	REPEAT_XOR_ERR_TOO_SHORT = -2,	/**< No key size fits twice. */
+	REPEAT_XOR_ERR_OOM = -3,
+	REPEAT_XOR_ERR_THREAD = -4,
+	REPEAT_XOR_ERR_SCORE_FAIL = -5
+} repeat_xor_status;
+
+/** @brief Target length of the replicated key pattern in bytes. */
+#define REPEAT_XOR_PERIOD 4096
+
+/**
+ * @brief Streaming state: the key, a replicated copy of short keys, and the
+ * position within the key where the next byte starts.
+ *
+ * Keys up to REPEAT_XOR_PERIOD bytes are copied into @c pattern; longer
+ * keys are used in place and must outlive the context.
+ */
+typedef struct
+{
+	const uint8_t *key;	/**< Caller's key bytes. */
+	size_t key_len;		/**< Key length in bytes. */
+	size_t offset;		/**< Key index applied to the next byte. */
+	size_t period;		/**< Pattern bytes per step (multiple of key_len). */
+	uint8_t pattern[2 * REPEAT_XOR_PERIOD];
+				/**< Key repeated period + key_len bytes. */
+} repeat_xor_ctx;
+
+/**
+ * @brief XOR @p len bytes with @p key repeated from its first byte.
+ *
+ * Works in place when @p out equals @p in. Uses a fixed-size pattern on the
+ * stack; nothing is allocated.
+ *
+ * @param in      Input bytes (may be NULL when @p len is 0).
+ * @param out     Output buffer of @p len bytes.
+ * @param len     Number of bytes to process.
+ * @param key     Key bytes.
+ * @param key_len Key length; must be non-zero.
+ * @return REPEAT_XOR_OK on success or an error status on failure.
+ */
+repeat_xor_status repeating_key_xor(const uint8_t * in, uint8_t * out,
+    size_t len, const uint8_t * key, size_t key_len);
+
+/**
+ * @brief Prepare @p ctx to XOR a stream with @p key, starting at key index 0.
+ */
+repeat_xor_status repeat_xor_init(repeat_xor_ctx * ctx, const uint8_t * key,
+    size_t key_len);
+
+/**
+ * @brief XOR the next @p len bytes of a stream, continuing the key where the
+ * previous call left off.
+ *
+ * Chunks may have any length; the output is the same as a single
+ * repeating_key_xor() over their concatenation. Works in place when @p out
+ * equals @p in.
+ */
+repeat_xor_status repeat_xor_update(repeat_xor_ctx * ctx, const uint8_t * in,
+    uint8_t * out, size_t len);
+
+/** @brief Longest key repeat_xor_break() will consider. */
+#define REPEAT_XOR_MAX_KEY 64
+
+/**
+ * @brief One recovered key for a candidate key size.
+ */
+typedef struct
+{
+	size_t key_len;		/**< Candidate key size in bytes. */
+	double distance;	/**< Normalized Hamming distance (bits/byte). */
+	double score;		/**< Mean English score over the key columns. */
+	uint8_t key[REPEAT_XOR_MAX_KEY];
+				/**< Recovered key; first key_len bytes valid. */
+} repeat_xor_candidate;
+
+/**
+ * @brief Recover repeating XOR keys from a ciphertext.
+ *
+ * Every size in [@p min_key, @p max_key] that fits at least twice is ranked
+ * by the Hamming distance between consecutive key-sized blocks, normalized
+ * by the size and averaged over up to REPEAT_XOR_SAMPLE bytes. For the
+ * @p top_cap lowest-distance sizes, the ciphertext is split into per-key-
+ * byte columns and each column is solved with
+ * brute_force_single_byte_xor_histogram(). Columns are spread across
+ * @p threads workers. Each worker keeps 2 KiB of counters per column, so
+ * the worker count is lowered when that would exceed a fixed budget.
+ *
+ * @param cipher  Ciphertext bytes.
+ * @param len     Ciphertext length.
+ * @param min_key Smallest key size to try (at least 1).
+ * @param max_key Largest key size to try (at most REPEAT_XOR_MAX_KEY).
+ * @param threads Worker count; 0 selects one per online CPU.
+ * @param top     Receives candidates, best (lowest distance) first.
+ * @param top_cap Capacity of @p top; the number of key sizes solved.
+ * @param top_len Receives the number of candidates written.
+ * @return REPEAT_XOR_OK on success or an error status on failure.
+ */
+repeat_xor_status repeat_xor_break(const uint8_t * cipher, size_t len,
+    size_t min_key, size_t max_key, size_t threads,
+    repeat_xor_candidate * top, size_t top_cap, size_t *top_len);
+
+/** @brief Bytes per key size sampled for the Hamming ranking. */
+#define REPEAT_XOR_SAMPLE (1u << 18)
+
+/**
+ * @brief Convert a repeat_xor_status value into a human-readable string.
+ */
+const char *repeat_xor_status_string(repeat_xor_status status);
+
+#endif /* REPEAT_XOR_H */
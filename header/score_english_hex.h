@@ -3,20 +3,109 @@
 
 /**
  * @file score_english_hex.h
- * @brief Estimate how closely hex-encoded data resembles English text.
+ * @brief Estimate how closely raw or hex-encoded data resembles English text.
  */
 
+#include <stddef.h>
+#include <stdint.h>
+
 typedef enum
 {
 	SCORE_ENGLISH_HEX_OK = 0,
 	SCORE_ENGLISH_HEX_ERR_ARGS = -1,
 	SCORE_ENGLISH_HEX_ERR_EMPTY = -2,
 	SCORE_ENGLISH_HEX_ERR_ODD_LENGTH = -3,
-	SCORE_ENGLISH_HEX_ERR_INVALID_HEX = -4
+	SCORE_ENGLISH_HEX_ERR_INVALID_HEX = -4,
+	SCORE_ENGLISH_HEX_PRUNED = 1	/**< Not an error; see below. */
 } score_english_hex_status;
 
+/**
+ * @brief Score a raw byte buffer for English-likeness.
+ *
+ * @param bytes     Text to score (may be NULL when @p len is 0).
+ * @param len       Number of bytes in @p bytes.
+ * @param score_out Receives the score (higher is more English-like).
+ * @return SCORE_ENGLISH_HEX_ERR_EMPTY when @p len is 0.
+ */
+score_english_hex_status score_english_bytes(const uint8_t * bytes,
+    size_t len, double *score_out);
+
+/**
+ * @brief Score a NUL-terminated hex string as the bytes it encodes.
+ *
+ * Digits are decoded by hex_to_bytes_n() a stack window at a time into the
+ * same counting kernel score_english_bytes() uses, so the score matches
+ * scoring the decoded bytes and no heap copy is made.
+ */
 score_english_hex_status score_english_hex(const char *hex, double *score_out);
 
+/**
+ * @brief score_english_hex() for a hex view of @p hex_len characters that
+ * need not be NUL-terminated, such as a line of a mapped file.
+ */
+score_english_hex_status score_english_hex_n(const char *hex, size_t hex_len,
+    double *score_out);
+
+/**
+ * @brief Score the plaintext described by a byte histogram XORed with a key.
+ *
+ * @p hist holds how often each byte value occurs in a ciphertext; the score
+ * is that of the plaintext obtained by XORing every byte with @p xor_key.
+ * The result is identical to scoring the decoded plaintext directly, but the
+ * cost is independent of the text length, so all 256 single-byte keys can be
+ * ranked from one pass over the ciphertext.
+ *
+ * @param hist      Occurrence count for each byte value.
+ * @param xor_key   Key applied to every byte before scoring.
+ * @param score_out Receives the score (higher is more English-like).
+ */
+score_english_hex_status score_english_histogram(const uint64_t hist[256],
+    uint8_t xor_key, double *score_out);
+
+/**
+ * @brief score_english_histogram() over only the byte values that occur.
+ *
+ * @p values lists the distinct cipher bytes and @p counts how often each
+ * occurs. A short text has few distinct bytes, so trying every key costs
+ * far less than walking all 256 histogram entries per key. The score is
+ * identical to score_english_histogram() on the equivalent histogram.
+ *
+ * @param values    Distinct cipher byte values.
+ * @param counts    Occurrence count of each value.
+ * @param n         Number of entries in @p values and @p counts.
+ * @param xor_key   Key applied to every byte before scoring.
+ * @param score_out Receives the score (higher is more English-like).
+ */
+score_english_hex_status score_english_distinct(const uint8_t * values,
+    const uint64_t * counts, size_t n, uint8_t xor_key, double *score_out);
+
+/**
+ * @brief score_english_distinct() that gives up as soon as the text
+ * provably cannot score above @p threshold.
+ *
+ * No text scores above 50 minus 50 per non-printable byte, so the
+ * penalties of the values examined so far bound the final score. Listing
+ * @p values by descending count makes that prefix cover most of the text:
+ * a key that turns the commonest byte into a control character is
+ * rejected after one entry. A text examined to the end gets the same score
+ * as score_english_distinct().
+ *
+ * @param values       Distinct cipher byte values, commonest first.
+ * @param counts       Occurrence count of each value.
+ * @param n            Number of entries in @p values and @p counts.
+ * @param xor_key      Key applied to every byte before scoring.
+ * @param threshold    Scores below this are not needed; pass -HUGE_VAL to
+ *                     always score the whole text.
+ * @param score_out    Receives the score, or the bound when pruned.
+ * @param examined_out Optional; receives how many entries were examined.
+ * @return SCORE_ENGLISH_HEX_PRUNED when the bound fell below @p threshold
+ *         before the last entry.
+ */
+score_english_hex_status score_english_distinct_bounded(
+    const uint8_t * values, const uint64_t * counts, size_t n,
+    uint8_t xor_key, double threshold, double *score_out,
+    size_t *examined_out);
+
 const char *score_english_hex_status_string(score_english_hex_status status);
 
 #endif /* SCORE_ENGLISH_HEX_H */
@@ -0,0 +1,117 @@
+#ifndef STATS_H
+#define STATS_H
+
+/**
+ * @file stats.h
+ * @brief Optional per-primitive call, byte and time counters.
+ *
+ * Built with -DCRYPTOPALS_STATS (make STATS=1), every instrumented
+ * primitive adds its call count, input bytes and elapsed nanoseconds to
+ * counters private to the calling thread. stats_dump() sums every thread's
+ * counters, including threads that have exited. Nested primitives count in
+ * both places: the hex decode inside a single-byte XOR solve shows up
+ * under hex_decode and under single_byte_xor.
+ *
+ * Without the flag STATS_SCOPE() expands to nothing, so instrumented code
+ * compiles exactly as before.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+/** @brief Instrumented primitives. */
+typedef enum
+{
+	STATS_HEX_DECODE = 0,
+	STATS_HEX_ENCODE,
+	STATS_BASE64_ENCODE,
+	STATS_BASE64_DECODE,
+	STATS_FIXED_XOR,
+	STATS_REPEAT_XOR,
+	STATS_SCORE_ENGLISH,
+	STATS_KEY_RANK,		/**< Ranking all 256 keys from a histogram. */
+	STATS_SINGLE_BYTE_XOR,	/**< A whole brute_force_single_byte_xor_n(). */
+	STATS_HAMMING,
+	STATS_TRANSPOSE,
+	STATS_AES,
+	STATS_COUNT
+} stats_primitive;
+
+/** @brief Totals for one primitive. */
+typedef struct
+{
+	uint64_t calls;
+	uint64_t bytes;
+	uint64_t ns;
+} stats_counter;
+
+/** @brief Name of @p primitive as printed by stats_dump(). */
+const char *stats_primitive_name(stats_primitive primitive);
+
+/**
+ * @brief Sum every thread's counters into @p out (STATS_COUNT entries).
+ *
+ * Without CRYPTOPALS_STATS the totals are all zero.
+ */
+void stats_snapshot(stats_counter * out);
+
+/**
+ * @brief Print one line per primitive that was called, to @p out.
+ *
+ * Prints nothing without CRYPTOPALS_STATS.
+ */
+void stats_dump(FILE * out);
+
+/**
+ * @brief Arrange for stats_dump(stderr) to run at process exit.
+ *
+ * Tools call this first thing in main(); without CRYPTOPALS_STATS it does
+ * nothing.
+ */
+void stats_dump_at_exit(void);
+
+#ifdef CRYPTOPALS_STATS
+
+#include <time.h>
+
+/** @brief An open measurement; closed when it goes out of scope. */
+typedef struct
+{
+	stats_primitive primitive;
+	uint64_t bytes;
+	uint64_t start;
+} stats_scope;
+
+void stats_record(stats_primitive primitive, uint64_t bytes, uint64_t ns);
+
+static inline uint64_t
+stats_now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+static inline void
+stats_scope_close(stats_scope *scope)
+{
+	stats_record(scope->primitive, scope->bytes,
+	    stats_now_ns() - scope->start);
+}
+
+/**
+ * @brief Count the rest of the enclosing block as one call of @p primitive
+ * over @p bytes input bytes, whichever way the block is left.
+ */
+#define STATS_SCOPE(primitive, bytes)					\
+	stats_scope stats_scope_					\
+	    __attribute__((cleanup(stats_scope_close))) =		\
+	    { (primitive), (uint64_t) (bytes), stats_now_ns() }
+
+#else
+
+#define STATS_SCOPE(primitive, bytes) do { } while (0)
+
+#endif /* CRYPTOPALS_STATS */
+
+#endif /* STATS_H */
@@ -20,23 +20,182 @@ typedef enum
 	UTILS_ERR_SCORE_FAIL = -6
 } utils_status;
 
+/**
+ * @brief A hex ciphertext view; it need not be NUL-terminated.
+ */
+typedef struct
+{
+	const char *hex;	/**< First hex digit. */
+	size_t len;		/**< Length in hex digits. */
+} utils_hex_view;
+
+/**
+ * @brief Outcome of solving one ciphertext of a batch.
+ */
+typedef struct
+{
+	uint8_t key;		/**< Best single-byte key. */
+	double score;		/**< Score of the decrypted plaintext. */
+	size_t plain_offset;	/**< Start of the plaintext in the arena. */
+	size_t plain_len;	/**< Plaintext length; 0 unless status is OK. */
+	utils_status status;	/**< Per-ciphertext result. */
+} utils_xor_result;
+
+/**
+ * @brief One ranked single-byte XOR key.
+ */
+typedef struct
+{
+	uint8_t key;		/**< Candidate key. */
+	double score;		/**< Score of the plaintext under @p key. */
+} utils_key_score;
+
 int hex_digit_value(int c);
 
 utils_status hex_to_bytes(const char *hex,
     uint8_t * out, size_t out_cap, size_t *out_len);
 
+/**
+ * @brief hex_to_bytes() for a hex view of @p hex_len characters.
+ *
+ * @p hex need not be NUL-terminated, so slices of a mapped file can be
+ * decoded in place.
+ */
+utils_status hex_to_bytes_n(const char *hex, size_t hex_len,
+    uint8_t * out, size_t out_cap, size_t *out_len);
+
 utils_status bytes_to_hex(const uint8_t * bytes,
     size_t len, char *out_hex, size_t out_cap);
 
 utils_status hex_to_ascii(const char *hex, char *ascii_out, size_t ascii_cap);
 
+/**
+ * @brief hex_to_ascii() for a hex view of @p hex_len characters that need
+ * not be NUL-terminated. The output is still NUL-terminated.
+ */
+utils_status hex_to_ascii_n(const char *hex, size_t hex_len, char *ascii_out,
+    size_t ascii_cap);
+
+/**
+ * @brief Count how often each byte value occurs in @p bytes.
+ *
+ * @param bytes Input buffer (may be NULL when @p len is 0).
+ * @param len   Number of bytes to count.
+ * @param hist  Receives 256 occurrence counts.
+ */
+utils_status utils_byte_histogram(const uint8_t * bytes, size_t len,
+    uint64_t hist[256]);
+
+/**
+ * @brief Find the single-byte XOR key whose plaintext scores most English-like.
+ *
+ * Every key is scored from the ciphertext byte histogram alone, so the
+ * ciphertext is never re-encoded or XORed per key. Ties resolve to the lowest
+ * key, matching brute_force_single_byte_xor().
+ *
+ * @param hist      Ciphertext histogram from utils_byte_histogram().
+ * @param out_key   Receives the best key.
+ * @param out_score Optional pointer that receives the best score.
+ */
+utils_status brute_force_single_byte_xor_histogram(const uint64_t hist[256],
+    uint8_t * out_key, double *out_score);
+
 utils_status brute_force_single_byte_xor(const char *hex_input,
     uint8_t * out_plain,
     size_t out_cap, size_t *out_len, uint8_t * out_key, double *out_score);
 
+/**
+ * @brief brute_force_single_byte_xor() for a hex view of @p hex_len
+ * characters that need not be NUL-terminated.
+ */
+utils_status brute_force_single_byte_xor_n(const char *hex_input,
+    size_t hex_len, uint8_t * out_plain, size_t out_cap, size_t *out_len,
+    uint8_t * out_key, double *out_score);
+
+/**
+ * @brief Solve many single-byte XOR ciphertexts in one call.
+ *
+ * Plaintexts are decoded back to back into the caller's @p arena: input i
+ * starts at the sum of len / 2 over the inputs before it, whether or not
+ * those decoded. Nothing is allocated, and because every offset follows
+ * from the lengths alone, disjoint slices of one batch can be handed to
+ * separate threads against the same arena.
+ *
+ * A malformed ciphertext (empty, odd length or invalid hex) only sets its
+ * own result's status; the rest of the batch is still solved.
+ *
+ * @param inputs    Ciphertexts to solve.
+ * @param count     Number of entries in @p inputs and @p results.
+ * @param arena     Plaintext arena.
+ * @param arena_cap Capacity of @p arena; at least the sum of len / 2.
+ * @param results   Receives one result per input.
+ * @return UTILS_ERR_BUFFER_TOO_SMALL, without writing any result, when the
+ *         arena cannot hold every plaintext.
+ */
+utils_status brute_force_single_byte_xor_batch(const utils_hex_view * inputs,
+    size_t count, uint8_t * arena, size_t arena_cap,
+    utils_xor_result * results);
+
+/**
+ * @brief Rank the @p k single-byte XOR keys whose plaintexts score most
+ * English-like.
+ *
+ * The histogram is walked commonest value first, and each key is dropped
+ * as soon as the penalties seen so far put it below the k-th best score
+ * (score_english_distinct_bounded()). Once k plausible keys are known,
+ * most keys are rejected after the first few entries instead of being
+ * scored over every distinct byte. Keys near the one that maps the
+ * commonest byte to a space are tried first so the bar rises early; the
+ * result does not depend on that order. Entries are sorted by descending
+ * score, ties by ascending key, so the first matches
+ * brute_force_single_byte_xor_histogram().
+ *
+ * @param hist         Ciphertext histogram from utils_byte_histogram();
+ *                     must not be empty.
+ * @param k            Number of keys wanted; more than 256 yields 256.
+ * @param out          Receives min(@p k, 256) entries.
+ * @param out_count    Receives the number of entries written.
+ * @param out_examined Optional; receives the histogram entries examined
+ *                     over all keys, at most 256 per distinct byte.
+ */
+utils_status brute_force_single_byte_xor_top_k(const uint64_t hist[256],
+    size_t k, utils_key_score * out, size_t *out_count,
+    size_t *out_examined);
+
 utils_status utils_repeat_key(const char *key,
     uint8_t * out, size_t buffer_len);
 
+/**
+ * @brief utils_repeat_key() for a key of @p key_len bytes, which may hold
+ * NUL bytes and need not be NUL-terminated.
+ */
+utils_status utils_repeat_key_n(const char *key, size_t key_len,
+    uint8_t * out, size_t buffer_len);
+
+/**
+ * @brief Split @p in into @p columns interleaved columns in one blocked pass.
+ *
+ * Byte i belongs to column i % @p columns. Columns are written back to back
+ * into @p out: with rows = len / columns and extra = len % columns, column c
+ * starts at c * rows + min(c, extra) and holds rows + (c < extra) bytes.
+ * The input is walked in cache-sized blocks of rows so the strided reads
+ * stay in L1 while every column is written sequentially.
+ *
+ * The byte histogram of each column is gathered in the same pass, so a
+ * single-byte solver never has to reread the data.
+ *
+ * @param in      Input bytes (may be NULL when @p len is 0).
+ * @param len     Number of input bytes.
+ * @param columns Number of columns (the key size); must be non-zero.
+ * @param out     Column arena of at least @p len bytes, or NULL to gather
+ *                histograms only.
+ * @param out_cap Capacity of @p out in bytes.
+ * @param hist    Optional @p columns * 256 counters; column c's histogram
+ *                is hist[c * 256 .. c * 256 + 255]. Overwritten.
+ */
+utils_status utils_transpose_columns(const uint8_t * in, size_t len,
+    size_t columns, uint8_t * out, size_t out_cap, uint64_t * hist);
+
 const char *utils_status_string(utils_status status);
 
 #endif /* UTILS_H */
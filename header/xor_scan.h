@@ -0,0 +1,76 @@
+#ifndef XOR_SCAN_H
+#define XOR_SCAN_H
+
+/**
+ * @file xor_scan.h
+ * @brief Parallel single-byte XOR detection across many hex lines.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hex_corpus.h"
+
+typedef enum
+{
+	XOR_SCAN_OK = 0,
+	XOR_SCAN_ERR_ARGS = -1,
+	XOR_SCAN_ERR_OOM = -2,
+	XOR_SCAN_ERR_THREAD = -3
+} xor_scan_status;
+
+/**
+ * @brief One scored line: its best single-byte key and English score.
+ */
+typedef struct
+{
+	size_t line;		/**< Zero-based index of the line. */
+	const char *hex;	/**< The line itself (not NUL-terminated). */
+	size_t hex_len;		/**< Length of @c hex in characters. */
+	uint8_t key;		/**< Best single-byte XOR key for the line. */
+	double score;		/**< Score of the line decrypted with @c key. */
+} xor_scan_result;
+
+/**
+ * @brief Brute-force every line and keep the @p top_cap best-scoring ones.
+ *
+ * Lines are split into contiguous shards, one per worker thread. Each worker
+ * keeps its own top-N heap and the heaps are merged once all workers finish,
+ * so threads never contend on shared state. Results are written to @p top
+ * ordered by descending score; equal scores keep the lower line first, which
+ * makes the output independent of the thread count.
+ *
+ * Lines that are empty or not valid hex are skipped.
+ *
+ * @param lines   Array of NUL-terminated hex strings.
+ * @param count   Number of entries in @p lines.
+ * @param threads Worker count; 0 selects one per online CPU.
+ * @param top     Destination for the best results.
+ * @param top_cap Capacity of @p top (the N in top-N); must be non-zero.
+ * @param top_len Receives the number of results written.
+ * @param skipped Optional pointer that receives the number of skipped lines.
+ */
+xor_scan_status xor_scan_lines(const char *const *lines, size_t count,
+    size_t threads, xor_scan_result * top, size_t top_cap,
+    size_t *top_len, size_t *skipped);
+
+/**
+ * @brief xor_scan_lines() over every non-blank line of a mapped corpus.
+ *
+ * Workers take contiguous byte ranges of the corpus and decode lines in
+ * place, so memory use is independent of the corpus size. @c line in each
+ * result counts non-blank lines from zero and @c hex points into the
+ * corpus.
+ */
+xor_scan_status xor_scan_corpus(const hex_corpus * corpus, size_t threads,
+    xor_scan_result * top, size_t top_cap, size_t *top_len,
+    size_t *skipped);
+
+/**
+ * @brief Number of workers used when a scan is asked for 0 threads.
+ */
+size_t xor_scan_default_threads(void);
+
+const char *xor_scan_status_string(xor_scan_status status);
+
+#endif /* XOR_SCAN_H */
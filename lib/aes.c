@@ -0,0 +1,408 @@
+/**
+ * @file aes.c
+ * @brief Implementation of the AES-128 block cipher.
+ *
+ * The portable path is the classic 32-bit lookup-table formulation: one
+ * table per direction combines SubBytes with MixColumns, and byte rotations
+ * stand in for the other three. The tables are derived from GF(2^8)
+ * arithmetic on first use instead of being spelled out here. Table lookups
+ * are indexed by secret data, so this path is not constant time.
+ *
+ * The AES-NI path keeps eight independent blocks in flight so the
+ * multi-cycle latency of AESENC/AESDEC is hidden behind throughput.
+ */
+
+#include "aes.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#include "cpu_features.h"
+#include "stats.h"
+
+#if CPU_FEATURES_X86
+#include <immintrin.h>
+#endif
+
+static uint8_t aes_sbox[256];
+static uint8_t aes_inv_sbox[256];
+static uint32_t aes_te[256];	/**< (2s, s, s, 3s) for s = S[x]. */
+static uint32_t aes_td[256];	/**< (14s, 9s, 13s, 11s) for s = Si[x]. */
+static pthread_once_t aes_tables_once = PTHREAD_ONCE_INIT;
+
+#define AES_LOAD32(p) ((uint32_t) (p)[0] << 24 | (uint32_t) (p)[1] << 16 | \
+	(uint32_t) (p)[2] << 8 | (uint32_t) (p)[3])
+#define AES_STORE32(p, v) do {						\
+	(p)[0] = (uint8_t) ((v) >> 24);					\
+	(p)[1] = (uint8_t) ((v) >> 16);					\
+	(p)[2] = (uint8_t) ((v) >> 8);					\
+	(p)[3] = (uint8_t) (v);						\
+} while (0)
+#define AES_ROR(v, n) ((v) >> (n) | (v) << (32 - (n)))
+
+const char *
+aes_status_string(aes_status status)
+{
+	switch (status) {
+	case AES_OK:
+		return "success";
+	case AES_ERR_ARGS:
+		return "invalid arguments";
+	case AES_ERR_LENGTH:
+		return "length is not a multiple of the AES block size";
+	default:
+		return "unknown aes error";
+	}
+}
+
+/** @brief Multiply in GF(2^8) modulo x^8 + x^4 + x^3 + x + 1. */
+static uint8_t
+aes_gmul(uint8_t a, uint8_t b)
+{
+	uint8_t p = 0;
+	while (b) {
+		if (b & 1) {
+			p ^= a;
+		}
+		a = (uint8_t) ((a << 1) ^ (a & 0x80 ? 0x1B : 0));
+		b >>= 1;
+	}
+	return p;
+}
+
+/** @brief Build the S-boxes and round tables (FIPS-197 section 5.1.1). */
+static void
+aes_init_tables(void)
+{
+	// Walk the multiplicative group with generator 3, tracking p = 3^i
+	// and q = 3^-i, so q is the inverse of p at every step.
+	uint8_t p = 1;
+	uint8_t q = 1;
+	do {
+		p = (uint8_t) (p ^ (p << 1) ^ (p & 0x80 ? 0x1B : 0));
+		q ^= (uint8_t) (q << 1);
+		q ^= (uint8_t) (q << 2);
+		q ^= (uint8_t) (q << 4);
+		if (q & 0x80) {
+			q ^= 0x09;
+		}
+		// Affine transformation of the inverse.
+		uint8_t s = (uint8_t) (q ^ (q << 1 | q >> 7) ^
+		    (q << 2 | q >> 6) ^ (q << 3 | q >> 5) ^
+		    (q << 4 | q >> 4) ^ 0x63);
+		aes_sbox[p] = s;
+	} while (p != 1);
+	aes_sbox[0] = 0x63;
+
+	for (int x = 0; x < 256; ++x) {
+		aes_inv_sbox[aes_sbox[x]] = (uint8_t) x;
+	}
+	for (int x = 0; x < 256; ++x) {
+		uint8_t s = aes_sbox[x];
+		aes_te[x] = (uint32_t) aes_gmul(s, 2) << 24 |
+		    (uint32_t) s << 16 | (uint32_t) s << 8 |
+		    (uint32_t) aes_gmul(s, 3);
+		uint8_t si = aes_inv_sbox[x];
+		aes_td[x] = (uint32_t) aes_gmul(si, 14) << 24 |
+		    (uint32_t) aes_gmul(si, 9) << 16 |
+		    (uint32_t) aes_gmul(si, 13) << 8 |
+		    (uint32_t) aes_gmul(si, 11);
+	}
+}
+
+/** @brief InvMixColumns of one column, via aes_td[] applied to S[b]. */
+static uint32_t
+aes_inv_mix_column(uint32_t w)
+{
+	return aes_td[aes_sbox[w >> 24]] ^
+	    AES_ROR(aes_td[aes_sbox[(w >> 16) & 0xFF]], 8) ^
+	    AES_ROR(aes_td[aes_sbox[(w >> 8) & 0xFF]], 16) ^
+	    AES_ROR(aes_td[aes_sbox[w & 0xFF]], 24);
+}
+
+aes_status
+aes128_expand_key(aes128_key *ks, const uint8_t key[AES128_KEY_SIZE])
+{
+	if (!ks || !key) {
+		return AES_ERR_ARGS;
+	}
+	pthread_once(&aes_tables_once, aes_init_tables);
+
+	uint32_t w[4 * (AES128_ROUNDS + 1)];
+	uint32_t rcon = 0x01;
+	for (int i = 0; i < 4; ++i) {
+		w[i] = AES_LOAD32(key + 4 * i);
+	}
+	for (int i = 4; i < 4 * (AES128_ROUNDS + 1); ++i) {
+		uint32_t t = w[i - 1];
+		if (i % 4 == 0) {
+			// SubWord(RotWord(t)) ^ Rcon.
+			t = (uint32_t) aes_sbox[(t >> 16) & 0xFF] << 24 |
+			    (uint32_t) aes_sbox[(t >> 8) & 0xFF] << 16 |
+			    (uint32_t) aes_sbox[t & 0xFF] << 8 |
+			    (uint32_t) aes_sbox[t >> 24];
+			t ^= rcon << 24;
+			rcon = aes_gmul((uint8_t) rcon, 2);
+		}
+		w[i] = w[i - 4] ^ t;
+	}
+
+	for (int r = 0; r <= AES128_ROUNDS; ++r) {
+		int d = AES128_ROUNDS - r;
+		for (int c = 0; c < 4; ++c) {
+			uint32_t word = w[4 * r + c];
+			AES_STORE32(ks->enc[r] + 4 * c, word);
+			if (d != 0 && d != AES128_ROUNDS) {
+				word = aes_inv_mix_column(word);
+			}
+			AES_STORE32(ks->dec[d] + 4 * c, word);
+		}
+	}
+	return AES_OK;
+}
+
+/** @brief Portable single-block encryption. */
+static void
+aes_encrypt_portable(const aes128_key *ks, const uint8_t *in, uint8_t *out)
+{
+	uint32_t s0 = AES_LOAD32(in) ^ AES_LOAD32(ks->enc[0]);
+	uint32_t s1 = AES_LOAD32(in + 4) ^ AES_LOAD32(ks->enc[0] + 4);
+	uint32_t s2 = AES_LOAD32(in + 8) ^ AES_LOAD32(ks->enc[0] + 8);
+	uint32_t s3 = AES_LOAD32(in + 12) ^ AES_LOAD32(ks->enc[0] + 12);
+
+	for (int r = 1; r < AES128_ROUNDS; ++r) {
+		const uint8_t *rk = ks->enc[r];
+		uint32_t t0 = aes_te[s0 >> 24] ^
+		    AES_ROR(aes_te[(s1 >> 16) & 0xFF], 8) ^
+		    AES_ROR(aes_te[(s2 >> 8) & 0xFF], 16) ^
+		    AES_ROR(aes_te[s3 & 0xFF], 24) ^ AES_LOAD32(rk);
+		uint32_t t1 = aes_te[s1 >> 24] ^
+		    AES_ROR(aes_te[(s2 >> 16) & 0xFF], 8) ^
+		    AES_ROR(aes_te[(s3 >> 8) & 0xFF], 16) ^
+		    AES_ROR(aes_te[s0 & 0xFF], 24) ^ AES_LOAD32(rk + 4);
+		uint32_t t2 = aes_te[s2 >> 24] ^
+		    AES_ROR(aes_te[(s3 >> 16) & 0xFF], 8) ^
+		    AES_ROR(aes_te[(s0 >> 8) & 0xFF], 16) ^
+		    AES_ROR(aes_te[s1 & 0xFF], 24) ^ AES_LOAD32(rk + 8);
+		uint32_t t3 = aes_te[s3 >> 24] ^
+		    AES_ROR(aes_te[(s0 >> 16) & 0xFF], 8) ^
+		    AES_ROR(aes_te[(s1 >> 8) & 0xFF], 16) ^
+		    AES_ROR(aes_te[s2 & 0xFF], 24) ^ AES_LOAD32(rk + 12);
+		s0 = t0;
+		s1 = t1;
+		s2 = t2;
+		s3 = t3;
+	}
+
+	// Final round: SubBytes and ShiftRows only.
+	const uint8_t *rk = ks->enc[AES128_ROUNDS];
+	uint32_t t0 = (uint32_t) aes_sbox[s0 >> 24] << 24 |
+	    (uint32_t) aes_sbox[(s1 >> 16) & 0xFF] << 16 |
+	    (uint32_t) aes_sbox[(s2 >> 8) & 0xFF] << 8 |
+	    (uint32_t) aes_sbox[s3 & 0xFF];
+	uint32_t t1 = (uint32_t) aes_sbox[s1 >> 24] << 24 |
+	    (uint32_t) aes_sbox[(s2 >> 16) & 0xFF] << 16 |
+	    (uint32_t) aes_sbox[(s3 >> 8) & 0xFF] << 8 |
+	    (uint32_t) aes_sbox[s0 & 0xFF];
+	uint32_t t2 = (uint32_t) aes_sbox[s2 >> 24] << 24 |
+	    (uint32_t) aes_sbox[(s3 >> 16) & 0xFF] << 16 |
+	    (uint32_t) aes_sbox[(s0 >> 8) & 0xFF] << 8 |
+	    (uint32_t) aes_sbox[s1 & 0xFF];
+	uint32_t t3 = (uint32_t) aes_sbox[s3 >> 24] << 24 |
+	    (uint32_t) aes_sbox[(s0 >> 16) & 0xFF] << 16 |
+	    (uint32_t) aes_sbox[(s1 >> 8) & 0xFF] << 8 |
+	    (uint32_t) aes_sbox[s2 & 0xFF];
+	AES_STORE32(out, t0 ^ AES_LOAD32(rk));
+	AES_STORE32(out + 4, t1 ^ AES_LOAD32(rk + 4));
+	AES_STORE32(out + 8, t2 ^ AES_LOAD32(rk + 8));
+	AES_STORE32(out + 12, t3 ^ AES_LOAD32(rk + 12));
+}
+
+/** @brief Portable single-block decryption (equivalent inverse cipher). */
+static void
+aes_decrypt_portable(const aes128_key *ks, const uint8_t *in, uint8_t *out)
+{
+	uint32_t s0 = AES_LOAD32(in) ^ AES_LOAD32(ks->dec[0]);
+	uint32_t s1 = AES_LOAD32(in + 4) ^ AES_LOAD32(ks->dec[0] + 4);
+	uint32_t s2 = AES_LOAD32(in + 8) ^ AES_LOAD32(ks->dec[0] + 8);
+	uint32_t s3 = AES_LOAD32(in + 12) ^ AES_LOAD32(ks->dec[0] + 12);
+
+	for (int r = 1; r < AES128_ROUNDS; ++r) {
+		const uint8_t *rk = ks->dec[r];
+		uint32_t t0 = aes_td[s0 >> 24] ^
+		    AES_ROR(aes_td[(s3 >> 16) & 0xFF], 8) ^
+		    AES_ROR(aes_td[(s2 >> 8) & 0xFF], 16) ^
+		    AES_ROR(aes_td[s1 & 0xFF], 24) ^ AES_LOAD32(rk);
+		uint32_t t1 = aes_td[s1 >> 24] ^
+		    AES_ROR(aes_td[(s0 >> 16) & 0xFF], 8) ^
+		    AES_ROR(aes_td[(s3 >> 8) & 0xFF], 16) ^
+		    AES_ROR(aes_td[s2 & 0xFF], 24) ^ AES_LOAD32(rk + 4);
+		uint32_t t2 = aes_td[s2 >> 24] ^
+		    AES_ROR(aes_td[(s1 >> 16) & 0xFF], 8) ^
+		    AES_ROR(aes_td[(s0 >> 8) & 0xFF], 16) ^
+		    AES_ROR(aes_td[s3 & 0xFF], 24) ^ AES_LOAD32(rk + 8);
+		uint32_t t3 = aes_td[s3 >> 24] ^
+		    AES_ROR(aes_td[(s2 >> 16) & 0xFF], 8) ^
+		    AES_ROR(aes_td[(s1 >> 8) & 0xFF], 16) ^
+		    AES_ROR(aes_td[s0 & 0xFF], 24) ^ AES_LOAD32(rk + 12);
+		s0 = t0;
+		s1 = t1;
+		s2 = t2;
+		s3 = t3;
+	}
+
+	// Final round: InvSubBytes and InvShiftRows only.
+	const uint8_t *rk = ks->dec[AES128_ROUNDS];
+	uint32_t t0 = (uint32_t) aes_inv_sbox[s0 >> 24] << 24 |
+	    (uint32_t) aes_inv_sbox[(s3 >> 16) & 0xFF] << 16 |
+	    (uint32_t) aes_inv_sbox[(s2 >> 8) & 0xFF] << 8 |
+	    (uint32_t) aes_inv_sbox[s1 & 0xFF];
+	uint32_t t1 = (uint32_t) aes_inv_sbox[s1 >> 24] << 24 |
+	    (uint32_t) aes_inv_sbox[(s0 >> 16) & 0xFF] << 16 |
+	    (uint32_t) aes_inv_sbox[(s3 >> 8) & 0xFF] << 8 |
+	    (uint32_t) aes_inv_sbox[s2 & 0xFF];
+	uint32_t t2 = (uint32_t) aes_inv_sbox[s2 >> 24] << 24 |
+	    (uint32_t) aes_inv_sbox[(s1 >> 16) & 0xFF] << 16 |
+	    (uint32_t) aes_inv_sbox[(s0 >> 8) & 0xFF] << 8 |
+	    (uint32_t) aes_inv_sbox[s3 & 0xFF];
+	uint32_t t3 = (uint32_t) aes_inv_sbox[s3 >> 24] << 24 |
+	    (uint32_t) aes_inv_sbox[(s2 >> 16) & 0xFF] << 16 |
+	    (uint32_t) aes_inv_sbox[(s1 >> 8) & 0xFF] << 8 |
+	    (uint32_t) aes_inv_sbox[s0 & 0xFF];
+	AES_STORE32(out, t0 ^ AES_LOAD32(rk));
+	AES_STORE32(out + 4, t1 ^ AES_LOAD32(rk + 4));
+	AES_STORE32(out + 8, t2 ^ AES_LOAD32(rk + 8));
+	AES_STORE32(out + 12, t3 ^ AES_LOAD32(rk + 12));
+}
+
+#if CPU_FEATURES_X86
+/**
+ * @brief AES-NI ECB over whole blocks, eight at a time, then singly.
+ *
+ * @p decrypt selects AESDEC with the inverse schedule; the loops are
+ * otherwise identical. Always inlined into the two callers below so the
+ * direction is a constant and the round loops carry no branch.
+ */
+__attribute__((target("aes,sse2"), always_inline))
+static inline void
+aes_ecb_aesni(const uint8_t (*schedule)[AES_BLOCK_SIZE], int decrypt,
+    const uint8_t *in, uint8_t *out, size_t len)
+{
+	__m128i rk[AES128_ROUNDS + 1];
+	for (int r = 0; r <= AES128_ROUNDS; ++r) {
+		rk[r] = _mm_loadu_si128((const __m128i *) schedule[r]);
+	}
+
+/*
+ * Eight named blocks rather than an array: at -O2 a b[8] loop is neither
+ * unrolled nor kept in registers, which serialises the rounds.
+ */
+#define AES_NI_EACH(op) do {						\
+	op(b0, 0); op(b1, 1); op(b2, 2); op(b3, 3);			\
+	op(b4, 4); op(b5, 5); op(b6, 6); op(b7, 7);			\
+} while (0)
+#define AES_NI_LOAD(b, j) (b) = _mm_xor_si128(_mm_loadu_si128(		\
+	(const __m128i *) (in + i + 16 * (j))), rk[0])
+#define AES_NI_ROUND(b, j) (b) = decrypt ? _mm_aesdec_si128((b), k) :	\
+	_mm_aesenc_si128((b), k)
+#define AES_NI_LAST(b, j) _mm_storeu_si128(				\
+	(__m128i *) (out + i + 16 * (j)), decrypt ?			\
+	_mm_aesdeclast_si128((b), k) : _mm_aesenclast_si128((b), k))
+
+	size_t i = 0;
+	for (; i + 8 * AES_BLOCK_SIZE <= len; i += 8 * AES_BLOCK_SIZE) {
+		__m128i b0, b1, b2, b3, b4, b5, b6, b7;
+		__m128i k;
+		AES_NI_EACH(AES_NI_LOAD);
+		for (int r = 1; r < AES128_ROUNDS; ++r) {
+			k = rk[r];
+			AES_NI_EACH(AES_NI_ROUND);
+		}
+		k = rk[AES128_ROUNDS];
+		AES_NI_EACH(AES_NI_LAST);
+	}
+#undef AES_NI_EACH
+#undef AES_NI_LOAD
+#undef AES_NI_ROUND
+#undef AES_NI_LAST
+
+	for (; i < len; i += AES_BLOCK_SIZE) {
+		__m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i *)
+		    (in + i)), rk[0]);
+		for (int r = 1; r < AES128_ROUNDS; ++r) {
+			b = decrypt ? _mm_aesdec_si128(b, rk[r]) :
+			    _mm_aesenc_si128(b, rk[r]);
+		}
+		b = decrypt ? _mm_aesdeclast_si128(b, rk[AES128_ROUNDS]) :
+		    _mm_aesenclast_si128(b, rk[AES128_ROUNDS]);
+		_mm_storeu_si128((__m128i *) (out + i), b);
+	}
+}
+
+__attribute__((target("aes,sse2")))
+static void
+aes_ecb_encrypt_aesni(const aes128_key *ks, const uint8_t *in, uint8_t *out,
+    size_t len)
+{
+	aes_ecb_aesni(ks->enc, 0, in, out, len);
+}
+
+__attribute__((target("aes,sse2")))
+static void
+aes_ecb_decrypt_aesni(const aes128_key *ks, const uint8_t *in, uint8_t *out,
+    size_t len)
+{
+	aes_ecb_aesni(ks->dec, 1, in, out, len);
+}
+#endif
+
+/** @brief Validate arguments and run ECB in the requested direction. */
+static aes_status
+aes_ecb(const aes128_key *ks, const uint8_t *in, uint8_t *out, size_t len,
+    int decrypt)
+{
+	STATS_SCOPE(STATS_AES, len);
+
+	if (!ks || ((!in || !out) && len > 0)) {
+		return AES_ERR_ARGS;
+	}
+	if (len % AES_BLOCK_SIZE != 0) {
+		return AES_ERR_LENGTH;
+	}
+
+#if CPU_FEATURES_X86
+	if (cpu_has(CPU_FEATURE_AESNI)) {
+		if (decrypt) {
+			aes_ecb_decrypt_aesni(ks, in, out, len);
+		} else {
+			aes_ecb_encrypt_aesni(ks, in, out, len);
+		}
+		return AES_OK;
+	}
+#endif
+	// The tables already exist if a key was expanded, but a zeroed
+	// schedule from elsewhere is still valid input.
+	pthread_once(&aes_tables_once, aes_init_tables);
+	for (size_t i = 0; i < len; i += AES_BLOCK_SIZE) {
+		if (decrypt) {
+			aes_decrypt_portable(ks, in + i, out + i);
+		} else {
+			aes_encrypt_portable(ks, in + i, out + i);
+		}
+	}
+	return AES_OK;
+}
+
+aes_status
+aes128_ecb_encrypt(const aes128_key *ks, const uint8_t *in, uint8_t *out,
+    size_t len)
+{
+	return aes_ecb(ks, in, out, len, 0);
+}
+
+aes_status
+aes128_ecb_decrypt(const aes128_key *ks, const uint8_t *in, uint8_t *out,
+    size_t len)
+{
+	return aes_ecb(ks, in, out, len, 1);
+}
@@ -0,0 +1,233 @@
+/**
+ * @file arena.c
+ * @brief Implementation of the bump allocator and scratch arenas.
+ */
+
+#include "arena.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Header at the start of every malloc()ed block.
+ */
+struct arena_block
+{
+	arena_block *next;
+	unsigned char *data;	/**< First usable byte, ARENA_MAX_ALIGN aligned. */
+	size_t size;		/**< Usable bytes from @c data. */
+	size_t used;		/**< Bytes handed out from @c data. */
+};
+
+static pthread_once_t arena_scratch_once = PTHREAD_ONCE_INIT;
+static pthread_key_t arena_scratch_key;
+static int arena_scratch_ready;
+static size_t arena_heap_block_count;
+
+void
+arena_init(arena *a)
+{
+	if (a) {
+		a->head = NULL;
+		a->spare = NULL;
+	}
+}
+
+/** @brief Allocate a fresh block with at least @p size usable bytes. */
+static arena_block *
+arena_block_new(size_t size)
+{
+	size_t overhead = sizeof(arena_block) + ARENA_MAX_ALIGN;
+	if (size > SIZE_MAX - overhead) {
+		return NULL;
+	}
+
+	// malloc() only guarantees max_align_t, so align the data by hand.
+	unsigned char *raw = malloc(overhead + size);
+	if (!raw) {
+		return NULL;
+	}
+	__atomic_add_fetch(&arena_heap_block_count, 1, __ATOMIC_RELAXED);
+	arena_block *block = (arena_block *) raw;
+	uintptr_t data = (uintptr_t) (raw + sizeof(arena_block));
+	data = (data + ARENA_MAX_ALIGN - 1) & ~(uintptr_t) (ARENA_MAX_ALIGN - 1);
+	block->next = NULL;
+	block->data = (unsigned char *) data;
+	block->size = size;
+	block->used = 0;
+	return block;
+}
+
+/**
+ * @brief Make a block with at least @p size free bytes the head.
+ *
+ * Spares are tried first, in order, so the same sequence of requests is
+ * served from the same blocks every time.
+ */
+static arena_block *
+arena_grow(arena *a, size_t size)
+{
+	arena_block **link = &a->spare;
+	while (*link && (*link)->size < size) {
+		link = &(*link)->next;
+	}
+
+	arena_block *block = *link;
+	if (block) {
+		*link = block->next;
+	} else {
+		size_t want = ARENA_MIN_BLOCK;
+		if (a->head && a->head->size <= SIZE_MAX / 2 &&
+		    2 * a->head->size > want) {
+			want = 2 * a->head->size;
+		}
+		if (size > want) {
+			want = size;
+		}
+		block = arena_block_new(want);
+		if (!block) {
+			return NULL;
+		}
+	}
+
+	block->used = 0;
+	block->next = a->head;
+	a->head = block;
+	return block;
+}
+
+void *
+arena_alloc(arena *a, size_t size, size_t align)
+{
+	if (align == 0) {
+		align = 1;
+	}
+	if (!a || (align & (align - 1)) != 0 || align > ARENA_MAX_ALIGN) {
+		return NULL;
+	}
+
+	arena_block *block = a->head;
+	if (block) {
+		size_t offset = (block->used + align - 1) & ~(align - 1);
+		if (offset <= block->size && size <= block->size - offset) {
+			block->used = offset + size;
+			return block->data + offset;
+		}
+	}
+
+	// Block data is maximally aligned, so offset 0 suits any request.
+	block = arena_grow(a, size);
+	if (!block) {
+		return NULL;
+	}
+	block->used = size;
+	return block->data;
+}
+
+void *
+arena_calloc(arena *a, size_t count, size_t size)
+{
+	if (size != 0 && count > SIZE_MAX / size) {
+		return NULL;
+	}
+	void *p = arena_alloc(a, count * size, _Alignof(max_align_t));
+	if (p) {
+		memset(p, 0, count * size);
+	}
+	return p;
+}
+
+arena_mark
+arena_save(const arena *a)
+{
+	arena_mark mark = { NULL, 0 };
+	if (a && a->head) {
+		mark.block = a->head;
+		mark.used = a->head->used;
+	}
+	return mark;
+}
+
+void
+arena_restore(arena *a, arena_mark mark)
+{
+	if (!a) {
+		return;
+	}
+	while (a->head && a->head != mark.block) {
+		arena_block *block = a->head;
+		a->head = block->next;
+		block->next = a->spare;
+		a->spare = block;
+	}
+	if (a->head) {
+		a->head->used = mark.used;
+	}
+}
+
+void
+arena_reset(arena *a)
+{
+	arena_mark empty = { NULL, 0 };
+	arena_restore(a, empty);
+}
+
+void
+arena_release(arena *a)
+{
+	if (!a) {
+		return;
+	}
+	arena_reset(a);
+	while (a->spare) {
+		arena_block *block = a->spare;
+		a->spare = block->next;
+		free(block);
+	}
+}
+
+static void
+arena_scratch_destroy(void *p)
+{
+	arena_release(p);
+	free(p);
+}
+
+static void
+arena_scratch_init(void)
+{
+	arena_scratch_ready = pthread_key_create(&arena_scratch_key,
+	    arena_scratch_destroy) == 0;
+}
+
+arena *
+arena_scratch(void)
+{
+	pthread_once(&arena_scratch_once, arena_scratch_init);
+	if (!arena_scratch_ready) {
+		return NULL;
+	}
+
+	arena *a = pthread_getspecific(arena_scratch_key);
+	if (a) {
+		return a;
+	}
+	a = malloc(sizeof(*a));
+	if (!a) {
+		return NULL;
+	}
+	arena_init(a);
+	if (pthread_setspecific(arena_scratch_key, a) != 0) {
+		free(a);
+		return NULL;
+	}
+	return a;
+}
+
+size_t
+arena_heap_blocks(void)
+{
+	return __atomic_load_n(&arena_heap_block_count, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,416 @@
+/**
+ * @file base64.c
+ * @brief Implementation of Base64 decoding helpers.
+ */
+
+#include "base64.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cpu_features.h"
+#include "stats.h"
+
+#if CPU_FEATURES_X86
+#include <immintrin.h>
+#endif
+
+#define WS -2
+#define PAD -3
+#define BAD -1
+
+/**
+ * @brief 6-bit value of each alphabet byte; WS, PAD and BAD mark the rest.
+ */
+static const int8_t b64_value[256] = {
+	/* 0x00 */ BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+	    BAD, WS, WS, WS, WS, WS, BAD, BAD,
+	/* 0x10 */ BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+	    BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+	/* 0x20 */ WS, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+	    BAD, BAD, BAD, 62, BAD, BAD, BAD, 63,
+	/* 0x30 */ 52, 53, 54, 55, 56, 57, 58, 59,
+	    60, 61, BAD, BAD, BAD, PAD, BAD, BAD,
+	/* 0x40 */ BAD, 0, 1, 2, 3, 4, 5, 6,
+	    7, 8, 9, 10, 11, 12, 13, 14,
+	/* 0x50 */ 15, 16, 17, 18, 19, 20, 21, 22,
+	    23, 24, 25, BAD, BAD, BAD, BAD, BAD,
+	/* 0x60 */ BAD, 26, 27, 28, 29, 30, 31, 32,
+	    33, 34, 35, 36, 37, 38, 39, 40,
+	/* 0x70 */ 41, 42, 43, 44, 45, 46, 47, 48,
+	    49, 50, 51, BAD, BAD, BAD, BAD, BAD,
+	/* 0x80 */ BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+	    BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+	/* 0x90 */ BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+	    BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+	/* 0xa0 */ BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+	    BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+	/* 0xb0 */ BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+	    BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+	/* 0xc0 */ BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+	    BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+	/* 0xd0 */ BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+	    BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+	/* 0xe0 */ BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+	    BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+	/* 0xf0 */ BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+	    BAD, BAD, BAD, BAD, BAD, BAD, BAD, BAD,
+};
+
+#undef WS
+#undef PAD
+#undef BAD
+
+/** @brief Input bytes read per fread() call in base64_decode_stream(). */
+#define BASE64_BLOCK 16384
+
+/** @brief Bytes a vector kernel may write past its last decoded byte. */
+#define BASE64_SLACK 8
+
+/**
+ * @brief Decoder state carried across input blocks.
+ */
+typedef struct
+{
+	uint32_t quad;		/**< Sextets of the group in progress. */
+	size_t nq;		/**< Characters in the group in progress. */
+	size_t pad;		/**< '=' characters in the group in progress. */
+	int done;		/**< Padding closed the input. */
+	size_t offset;		/**< Absolute offset of the next input byte. */
+} base64_decoder;
+
+const char *
+base64_status_string(base64_status status)
+{
+	switch (status) {
+	case BASE64_OK:
+		return "success";
+	case BASE64_ERR_ARGS:
+		return "invalid arguments";
+	case BASE64_ERR_INVALID_CHAR:
+		return "invalid Base64 character";
+	case BASE64_ERR_BAD_PADDING:
+		return "misplaced Base64 padding";
+	case BASE64_ERR_TRUNCATED:
+		return "truncated Base64 group";
+	case BASE64_ERR_OUTPUT_OVERFLOW:
+		return "output buffer too small";
+	case BASE64_ERR_IO:
+		return "input/output failure";
+	default:
+		return "unknown base64 error";
+	}
+}
+
+#if CPU_FEATURES_X86
+/*
+ * Vector decoders after Muła and Lemire, "Faster Base64 Encoding and
+ * Decoding using AVX2 Instructions". Two nibble lookups flag every byte
+ * outside the alphabet (whitespace and '=' included), a third maps each
+ * alphabet range to its offset, and two multiply-adds pack four sextets
+ * into three bytes per 32-bit lane.
+ *
+ * Each kernel returns how many characters it consumed (a multiple of its
+ * width) and stops at the first block containing a non-alphabet byte,
+ * leaving that block to the scalar decoder.
+ */
+
+/** @brief SSSE3 decoder: 16 characters to 12 bytes per iteration. */
+__attribute__((target("ssse3")))
+static size_t
+base64_decode_ssse3(const uint8_t *in, size_t len, uint8_t *out)
+{
+	const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11,
+	    0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+	const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04,
+	    0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71,
+	    -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14,
+	    13, 12, -1, -1, -1, -1);
+	const __m128i nibble = _mm_set1_epi8(0x0F);
+
+	size_t i = 0;
+	for (; i + 16 <= len; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *) (in + i));
+		__m128i hi_nib = _mm_and_si128(_mm_srli_epi32(v, 4), nibble);
+		__m128i lo = _mm_shuffle_epi8(lut_lo, _mm_and_si128(v, nibble));
+		__m128i hi = _mm_shuffle_epi8(lut_hi, hi_nib);
+		__m128i bad = _mm_and_si128(lo, hi);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(bad,
+			    _mm_setzero_si128())) != 0xFFFF) {
+			break;
+		}
+
+		__m128i slash = _mm_cmpeq_epi8(v, _mm_set1_epi8('/'));
+		__m128i roll = _mm_shuffle_epi8(lut_roll,
+		    _mm_add_epi8(slash, hi_nib));
+		v = _mm_add_epi8(v, roll);
+		v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+		v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+		_mm_storeu_si128((__m128i *) (out + i / 4 * 3),
+		    _mm_shuffle_epi8(v, pack));
+	}
+	return i;
+}
+
+/** @brief AVX2 decoder: 32 characters to 24 bytes per iteration. */
+__attribute__((target("avx2")))
+static size_t
+base64_decode_avx2(const uint8_t *in, size_t len, uint8_t *out)
+{
+	const __m256i lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11,
+	    0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+	    0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13,
+	    0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+	const __m256i lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04,
+	    0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+	    0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10,
+	    0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71,
+	    -71, 0, 0, 0, 0, 0, 0, 0, 0, 0, 16, 19, 4, -65, -65, -71, -71, 0,
+	    0, 0, 0, 0, 0, 0, 0);
+	const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14,
+	    13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+	    -1, -1, -1, -1);
+	const __m256i nibble = _mm256_set1_epi8(0x0F);
+
+	size_t i = 0;
+	for (; i + 32 <= len; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *) (in + i));
+		__m256i hi_nib = _mm256_and_si256(_mm256_srli_epi32(v, 4),
+		    nibble);
+		__m256i lo = _mm256_shuffle_epi8(lut_lo,
+		    _mm256_and_si256(v, nibble));
+		__m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nib);
+		if (!_mm256_testz_si256(lo, hi)) {
+			break;
+		}
+
+		__m256i slash = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('/'));
+		__m256i roll = _mm256_shuffle_epi8(lut_roll,
+		    _mm256_add_epi8(slash, hi_nib));
+		v = _mm256_add_epi8(v, roll);
+		v = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+		v = _mm256_madd_epi16(v, _mm256_set1_epi32(0x00011000));
+		v = _mm256_shuffle_epi8(v, pack);
+		v = _mm256_permutevar8x32_epi32(v,
+		    _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+		_mm256_storeu_si256((__m256i *) (out + i / 4 * 3), v);
+	}
+	return i;
+}
+#endif
+
+/** @brief Portable decoder: whole groups of four alphabet characters. */
+static size_t
+base64_decode_scalar(const uint8_t *in, size_t len, uint8_t *out)
+{
+	size_t i = 0;
+	for (; i + 4 <= len; i += 4) {
+		int32_t a = b64_value[in[i]];
+		int32_t b = b64_value[in[i + 1]];
+		int32_t c = b64_value[in[i + 2]];
+		int32_t d = b64_value[in[i + 3]];
+		if ((a | b | c | d) < 0) {
+			break;
+		}
+		uint32_t quad = (uint32_t) a << 18 | (uint32_t) b << 12 |
+		    (uint32_t) c << 6 | (uint32_t) d;
+		uint8_t *dst = out + i / 4 * 3;
+		dst[0] = (uint8_t) (quad >> 16);
+		dst[1] = (uint8_t) (quad >> 8);
+		dst[2] = (uint8_t) quad;
+	}
+	return i;
+}
+
+/**
+ * @brief Bulk-decode whole groups with the widest available kernel.
+ *
+ * @p out must have room for the decoded bytes plus BASE64_SLACK.
+ *
+ * @return Characters consumed (a multiple of 4).
+ */
+static size_t
+base64_decode_groups(const uint8_t *in, size_t len, uint8_t *out)
+{
+	size_t done = 0;
+#if CPU_FEATURES_X86
+	unsigned features = cpu_features();
+	if (features & CPU_FEATURE_AVX2) {
+		done = base64_decode_avx2(in, len, out);
+	}
+	if (features & CPU_FEATURE_SSSE3) {
+		done += base64_decode_ssse3(in + done, len - done,
+		    out + done / 4 * 3);
+	}
+#endif
+	return done + base64_decode_scalar(in + done, len - done,
+	    out + done / 4 * 3);
+}
+
+/**
+ * @brief Feed one character to the scalar state machine.
+ *
+ * @return BASE64_OK, or an error with @c d->offset naming the character.
+ */
+static base64_status
+base64_decode_char(base64_decoder *d, uint8_t ch, uint8_t *out,
+    size_t out_cap, size_t *produced)
+{
+	int8_t v = b64_value[ch];
+	if (v == -2) {
+		return BASE64_OK;
+	}
+	if (v == -1) {
+		return BASE64_ERR_INVALID_CHAR;
+	}
+	if (d->done) {
+		return BASE64_ERR_BAD_PADDING;
+	}
+
+	if (v == -3) {
+		// "xx==" and "xxx=" are the only legal padded groups.
+		if (d->nq < 2) {
+			return BASE64_ERR_BAD_PADDING;
+		}
+		d->pad++;
+		v = 0;
+	} else if (d->pad > 0) {
+		return BASE64_ERR_BAD_PADDING;
+	}
+
+	d->quad = (d->quad << 6) | (uint32_t) v;
+	if (++d->nq < 4) {
+		return BASE64_OK;
+	}
+
+	size_t n = 3 - d->pad;
+	if (n > out_cap - *produced) {
+		return BASE64_ERR_OUTPUT_OVERFLOW;
+	}
+	uint8_t *dst = out + *produced;
+	dst[0] = (uint8_t) (d->quad >> 16);
+	if (n > 1) {
+		dst[1] = (uint8_t) (d->quad >> 8);
+	}
+	if (n > 2) {
+		dst[2] = (uint8_t) d->quad;
+	}
+	*produced += n;
+	d->done = d->pad > 0;
+	d->quad = 0;
+	d->nq = 0;
+	d->pad = 0;
+	return BASE64_OK;
+}
+
+/**
+ * @brief Decode one block of input into @p out.
+ *
+ * Runs of unbroken alphabet characters that start on a group boundary go
+ * through the bulk kernels; whitespace, padding and group tails go through
+ * the character state machine, after which the bulk kernels are retried.
+ */
+static base64_status
+base64_decode_block(base64_decoder *d, const uint8_t *in, size_t len,
+    uint8_t *out, size_t out_cap, size_t *produced)
+{
+	size_t i = 0;
+	while (i < len) {
+		size_t used = 0;
+		size_t room = out_cap - *produced;
+		if (d->nq == 0 && !d->done && room > BASE64_SLACK) {
+			size_t fit = (room - BASE64_SLACK) / 3 * 4;
+			used = base64_decode_groups(in + i,
+			    len - i < fit ? len - i : fit, out + *produced);
+			i += used;
+			*produced += used / 4 * 3;
+			d->offset += used;
+		}
+
+		// Go scalar until the next group boundary that is followed by
+		// an alphabet character, always making progress.
+		while (i < len && (used == 0 || d->nq != 0 ||
+			b64_value[in[i]] < 0)) {
+			base64_status status = base64_decode_char(d, in[i],
+			    out, out_cap, produced);
+			if (status != BASE64_OK) {
+				return status;
+			}
+			i++;
+			d->offset++;
+			used = 1;
+		}
+	}
+	return BASE64_OK;
+}
+
+base64_status
+base64_to_bytes(const uint8_t *in, size_t in_len, uint8_t *out,
+    size_t out_cap, size_t *out_len, size_t *err_offset)
+{
+	STATS_SCOPE(STATS_BASE64_DECODE, in_len);
+
+	if ((!in && in_len > 0) || (!out && out_cap > 0)) {
+		return BASE64_ERR_ARGS;
+	}
+
+	base64_decoder d = { 0, 0, 0, 0, 0 };
+	size_t produced = 0;
+	base64_status status = base64_decode_block(&d, in, in_len, out,
+	    out_cap, &produced);
+	if (status == BASE64_OK && d.nq != 0) {
+		status = BASE64_ERR_TRUNCATED;
+	}
+	if (status != BASE64_OK) {
+		if (err_offset) {
+			*err_offset = d.offset;
+		}
+		return status;
+	}
+
+	if (out_len) {
+		*out_len = produced;
+	}
+	return BASE64_OK;
+}
+
+base64_status
+base64_decode_stream(FILE *in, FILE *out, size_t *err_offset)
+{
+	if (!in || !out) {
+		return BASE64_ERR_ARGS;
+	}
+
+	uint8_t block[BASE64_BLOCK];
+	uint8_t decoded[BASE64_BLOCK / 4 * 3 + 3 + BASE64_SLACK];
+	base64_decoder d = { 0, 0, 0, 0, 0 };
+	base64_status status = BASE64_OK;
+	size_t nread;
+
+	while ((nread = fread(block, 1, sizeof(block), in)) > 0) {
+		size_t produced = 0;
+		status = base64_decode_block(&d, block, nread, decoded,
+		    sizeof(decoded), &produced);
+		if (status != BASE64_OK) {
+			break;
+		}
+		if (fwrite(decoded, 1, produced, out) != produced) {
+			return BASE64_ERR_IO;
+		}
+	}
+
+	if (status == BASE64_OK && ferror(in)) {
+		return BASE64_ERR_IO;
+	}
+	if (status == BASE64_OK && d.nq != 0) {
+		status = BASE64_ERR_TRUNCATED;
+	}
+	if (status != BASE64_OK && err_offset) {
+		*err_offset = d.offset;
+	}
+	return status;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file corpus_scan.c
+ * @brief Implementation of the shared top-N heap and scanner scaffolding.
+ */
+
+#include "corpus_scan.h"
+
+#include <string.h>
+
+/**
+ * @brief Ordering used by the sift routines: @c worse with a context, so
+ * the same heap code ranks by score or by corpus position.
+ */
+typedef int (*corpus_scan_cmp)(const void *a, const void *b,
+    const void *ctx);
+
+static int
+corpus_scan_by_worse(const void *a, const void *b, const void *ctx)
+{
+	const corpus_scan_heap *heap = ctx;
+	return heap->worse(a, b);
+}
+
+/** @brief Later in the corpus ranks lower, so sorting yields corpus order. */
+static int
+corpus_scan_by_position(const void *a, const void *b, const void *ctx)
+{
+	size_t offset = *(const size_t *) ctx;
+	const char *pa;
+	const char *pb;
+	memcpy(&pa, (const char *) a + offset, sizeof(pa));
+	memcpy(&pb, (const char *) b + offset, sizeof(pb));
+	return pa > pb;
+}
+
+static void
+corpus_scan_swap(unsigned char *a, unsigned char *b, size_t size)
+{
+	for (size_t i = 0; i < size; ++i) {
+		unsigned char tmp = a[i];
+		a[i] = b[i];
+		b[i] = tmp;
+	}
+}
+
+/** @brief Move element @p i down until no child ranks below it. */
+static void
+corpus_scan_sift_down(unsigned char *base, size_t len, size_t size, size_t i,
+    corpus_scan_cmp worse, const void *ctx)
+{
+	for (;;) {
+		size_t left = 2 * i + 1;
+		size_t right = left + 1;
+		size_t weakest = i;
+		if (left < len && worse(base + left * size,
+			base + weakest * size, ctx)) {
+			weakest = left;
+		}
+		if (right < len && worse(base + right * size,
+			base + weakest * size, ctx)) {
+			weakest = right;
+		}
+		if (weakest == i) {
+			return;
+		}
+		corpus_scan_swap(base + i * size, base + weakest * size, size);
+		i = weakest;
+	}
+}
+
+/**
+ * @brief Heapsort @p len elements best first: build a min-heap, then move
+ * the weakest root to the back one at a time.
+ */
+static void
+corpus_scan_sort(unsigned char *base, size_t len, size_t size,
+    corpus_scan_cmp worse, const void *ctx)
+{
+	for (size_t i = len / 2; i-- > 0;) {
+		corpus_scan_sift_down(base, len, size, i, worse, ctx);
+	}
+	while (len > 1) {
+		len--;
+		corpus_scan_swap(base, base + len * size, size);
+		corpus_scan_sift_down(base, len, size, 0, worse, ctx);
+	}
+}
+
+void
+corpus_scan_heap_init(corpus_scan_heap *heap, void *items, size_t cap,
+    size_t size, corpus_scan_worse_fn worse)
+{
+	heap->items = items;
+	heap->len = 0;
+	heap->cap = cap;
+	heap->size = size;
+	heap->worse = worse;
+}
+
+void
+corpus_scan_heap_push(corpus_scan_heap *heap, const void *item)
+{
+	unsigned char *base = heap->items;
+	size_t size = heap->size;
+
+	if (heap->len < heap->cap) {
+		size_t i = heap->len++;
+		memcpy(base + i * size, item, size);
+		while (i > 0) {
+			size_t parent = (i - 1) / 2;
+			if (!heap->worse(base + i * size, base + parent * size)) {
+				break;
+			}
+			corpus_scan_swap(base + i * size, base + parent * size,
+			    size);
+			i = parent;
+		}
+		return;
+	}
+
+	if (heap->len == 0 || !heap->worse(base, item)) {
+		return;
+	}
+	memcpy(base, item, size);
+	corpus_scan_sift_down(base, heap->len, size, 0, corpus_scan_by_worse,
+	    heap);
+}
+
+void
+corpus_scan_heap_merge(corpus_scan_heap *into, const corpus_scan_heap *from)
+{
+	const unsigned char *base = from->items;
+	for (size_t i = 0; i < from->len; ++i) {
+		corpus_scan_heap_push(into, base + i * from->size);
+	}
+}
+
+void
+corpus_scan_heap_sort(corpus_scan_heap *heap)
+{
+	corpus_scan_sort(heap->items, heap->len, heap->size,
+	    corpus_scan_by_worse, heap);
+}
+
+void
+corpus_scan_number_lines(corpus_scan_heap *heap, const hex_corpus *corpus,
+    size_t hex_offset, size_t line_offset)
+{
+	unsigned char *base = heap->items;
+	corpus_scan_sort(base, heap->len, heap->size, corpus_scan_by_position,
+	    &hex_offset);
+
+	hex_corpus_cursor cursor;
+	hex_corpus_line view;
+	size_t line = 0;
+	size_t next = 0;
+	hex_corpus_shard(corpus, 0, 1, &cursor);
+	while (next < heap->len && hex_corpus_next(&cursor, &view)) {
+		for (;;) {
+			unsigned char *item = base + next * heap->size;
+			const char *hex;
+			memcpy(&hex, item + hex_offset, sizeof(hex));
+			if (hex != view.data) {
+				break;
+			}
+			memcpy(item + line_offset, &line, sizeof(line));
+			if (++next == heap->len) {
+				break;
+			}
+		}
+		line++;
+	}
+}
+
+int
+corpus_scan_run_workers(void *workers, size_t stride, size_t threads,
+    pthread_t *tids, void *(*fn)(void *))
+{
+	unsigned char *base = workers;
+	int result = 0;
+	size_t started = 1;
+	for (; started < threads; ++started) {
+		if (pthread_create(&tids[started], NULL, fn,
+			base + started * stride) != 0) {
+			result = -1;
+			break;
+		}
+	}
+	fn(base);
+	for (size_t t = 1; t < started; ++t) {
+		pthread_join(tids[t], NULL);
+	}
+	return result;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file cpu_features.c
+ * @brief Implementation of runtime CPU feature detection.
+ */
+
+#include "cpu_features.h"
+
+#include <pthread.h>
+
+static unsigned cpu_features_mask = ~0u;
+static unsigned cpu_features_detected;
+static pthread_once_t cpu_features_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Query the CPU into cpu_features_detected; runs once per process,
+ * so dispatchers on short inputs only pay for a load and a mask.
+ */
+static void
+cpu_features_detect(void)
+{
+	unsigned features = 0;
+#if CPU_FEATURES_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse2")) {
+		features |= CPU_FEATURE_SSE2;
+	}
+	if (__builtin_cpu_supports("ssse3")) {
+		features |= CPU_FEATURE_SSSE3;
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		features |= CPU_FEATURE_AVX2;
+	}
+	if (__builtin_cpu_supports("avx512f")) {
+		features |= CPU_FEATURE_AVX512F;
+	}
+	if (__builtin_cpu_supports("popcnt")) {
+		features |= CPU_FEATURE_POPCNT;
+	}
+	if (__builtin_cpu_supports("avx512vpopcntdq")) {
+		features |= CPU_FEATURE_AVX512VPOPCNTDQ;
+	}
+	if (__builtin_cpu_supports("aes")) {
+		features |= CPU_FEATURE_AESNI;
+	}
+#endif
+	cpu_features_detected = features;
+}
+
+unsigned
+cpu_features(void)
+{
+	pthread_once(&cpu_features_once, cpu_features_detect);
+	return cpu_features_detected & cpu_features_mask;
+}
+
+int
+cpu_has(unsigned features)
+{
+	return (cpu_features() & features) == features;
+}
+
+void
+cpu_features_set_mask(unsigned mask)
+{
+	cpu_features_mask = mask;
+}
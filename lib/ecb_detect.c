@@ -0,0 +1,303 @@
+/**
+ * @file ecb_detect.c
+ * @brief Implementation of repeated-block ECB detection.
+ */
+
+#include "ecb_detect.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "arena.h"
+#include "corpus_scan.h"
+#include "utils.h"
+#include "xor_scan.h"
+
+/** @brief Smallest hash set allocated, in slots. */
+#define ECB_DETECT_MIN_SLOTS 64
+
+/**
+ * @brief One hash set slot; it is occupied when @c gen matches the set's.
+ */
+typedef struct
+{
+	uint64_t lo;
+	uint64_t hi;
+	uint32_t gen;
+} ecb_detect_slot;
+
+/**
+ * @brief Open-addressing set of 16-byte blocks, reused across lines.
+ */
+typedef struct
+{
+	arena *scratch;		/**< Where the slot table is allocated. */
+	ecb_detect_slot *slots;
+	size_t mask;		/**< Slot count minus one (a power of two). */
+	uint32_t gen;		/**< Tag of the line being counted. */
+} ecb_detect_set;
+
+typedef struct
+{
+	hex_corpus_cursor cursor;
+	corpus_scan_heap heap;
+	size_t skipped;
+	ecb_detect_status status;
+} ecb_detect_worker;
+
+const char *
+ecb_detect_status_string(ecb_detect_status status)
+{
+	switch (status) {
+	case ECB_DETECT_OK:
+		return "success";
+	case ECB_DETECT_ERR_ARGS:
+		return "invalid arguments";
+	case ECB_DETECT_ERR_OOM:
+		return "out of memory";
+	case ECB_DETECT_ERR_THREAD:
+		return "failed to start worker thread";
+	default:
+		return "unknown ecb_detect error";
+	}
+}
+
+/**
+ * @brief Start counting a new buffer of @p blocks blocks.
+ *
+ * Keeps the load factor at or below one half, growing the table only when
+ * needed; otherwise bumping the generation empties it.
+ */
+static ecb_detect_status
+ecb_detect_set_reset(ecb_detect_set *set, size_t blocks)
+{
+	size_t want = ECB_DETECT_MIN_SLOTS;
+	while (want < 2 * blocks) {
+		want *= 2;
+	}
+
+	if (!set->slots || want > set->mask + 1) {
+		// The old table stays in the arena until the caller restores
+		// it; tables double, so the waste is at most one more table.
+		ecb_detect_slot *slots = arena_calloc(set->scratch, want,
+		    sizeof(*slots));
+		if (!slots) {
+			return ECB_DETECT_ERR_OOM;
+		}
+		set->slots = slots;
+		set->mask = want - 1;
+		set->gen = 1;
+		return ECB_DETECT_OK;
+	}
+
+	if (++set->gen == 0) {
+		// Wrapped: stale tags could collide with the new one.
+		memset(set->slots, 0, (set->mask + 1) * sizeof(*set->slots));
+		set->gen = 1;
+	}
+	return ECB_DETECT_OK;
+}
+
+/**
+ * @brief Insert one block.
+ *
+ * @return 1 when the block was already present, 0 when it was added.
+ */
+static int
+ecb_detect_set_insert(ecb_detect_set *set, const uint8_t *block)
+{
+	uint64_t lo, hi;
+	memcpy(&lo, block, sizeof(lo));
+	memcpy(&hi, block + 8, sizeof(hi));
+
+	uint64_t h = lo * 0x9E3779B97F4A7C15ULL ^ hi * 0xC2B2AE3D27D4EB4FULL;
+	size_t i = (size_t) (h ^ (h >> 32)) & set->mask;
+	for (;;) {
+		ecb_detect_slot *slot = &set->slots[i];
+		if (slot->gen != set->gen) {
+			slot->lo = lo;
+			slot->hi = hi;
+			slot->gen = set->gen;
+			return 0;
+		}
+		if (slot->lo == lo && slot->hi == hi) {
+			return 1;
+		}
+		i = (i + 1) & set->mask;
+	}
+}
+
+/** @brief Count repeated blocks of one buffer with a reset set. */
+static ecb_detect_status
+ecb_detect_set_count(ecb_detect_set *set, const uint8_t *bytes, size_t len,
+    size_t *repeats)
+{
+	size_t blocks = len / ECB_DETECT_BLOCK;
+	ecb_detect_status status = ecb_detect_set_reset(set, blocks);
+	if (status != ECB_DETECT_OK) {
+		return status;
+	}
+
+	size_t count = 0;
+	for (size_t b = 0; b < blocks; ++b) {
+		count += (size_t) ecb_detect_set_insert(set,
+		    bytes + b * ECB_DETECT_BLOCK);
+	}
+	*repeats = count;
+	return ECB_DETECT_OK;
+}
+
+ecb_detect_status
+ecb_detect_count_repeats(const uint8_t *bytes, size_t len, size_t *repeats)
+{
+	if ((!bytes && len > 0) || !repeats) {
+		return ECB_DETECT_ERR_ARGS;
+	}
+
+	ecb_detect_set set = { arena_scratch(), NULL, 0, 0 };
+	if (!set.scratch) {
+		return ECB_DETECT_ERR_OOM;
+	}
+	arena_mark mark = arena_save(set.scratch);
+	ecb_detect_status status = ecb_detect_set_count(&set, bytes, len,
+	    repeats);
+	arena_restore(set.scratch, mark);
+	return status;
+}
+
+/** @brief Return non-zero when @p a ranks below @p b. */
+static int
+ecb_detect_worse(const void *lhs, const void *rhs)
+{
+	const ecb_detect_result *a = lhs;
+	const ecb_detect_result *b = rhs;
+
+	if (a->repeats != b->repeats) {
+		return a->repeats < b->repeats;
+	}
+	// Lines are numbered after the merge; until then their position in
+	// the mapping orders them the same way.
+	return a->hex > b->hex;
+}
+
+static void *
+ecb_detect_worker_run(void *arg)
+{
+	ecb_detect_worker *worker = arg;
+	ecb_detect_set set = { arena_scratch(), NULL, 0, 0 };
+	if (!set.scratch) {
+		worker->status = ECB_DETECT_ERR_OOM;
+		return NULL;
+	}
+	arena_mark mark = arena_save(set.scratch);
+	uint8_t *bytes = NULL;
+	size_t bytes_cap = 0;
+	hex_corpus_line view;
+
+	while (hex_corpus_next(&worker->cursor, &view)) {
+		// Grows to the longest line seen, never with the corpus size.
+		size_t need = view.len / 2;
+		if (need > bytes_cap) {
+			size_t cap = 2 * bytes_cap > need ? 2 * bytes_cap : need;
+			bytes = arena_alloc(set.scratch, cap, ECB_DETECT_BLOCK);
+			if (!bytes) {
+				worker->status = ECB_DETECT_ERR_OOM;
+				break;
+			}
+			bytes_cap = cap;
+		}
+
+		size_t len = 0;
+		if (hex_to_bytes_n(view.data, view.len, bytes, bytes_cap,
+			&len) != UTILS_OK) {
+			worker->skipped++;
+			continue;
+		}
+
+		ecb_detect_result result = { SIZE_MAX, view.data, view.len,
+			len / ECB_DETECT_BLOCK, 0 };
+		worker->status = ecb_detect_set_count(&set, bytes, len,
+		    &result.repeats);
+		if (worker->status != ECB_DETECT_OK) {
+			break;
+		}
+		corpus_scan_heap_push(&worker->heap, &result);
+	}
+
+	arena_restore(set.scratch, mark);
+	return NULL;
+}
+
+ecb_detect_status
+ecb_detect_corpus(const hex_corpus *corpus, size_t threads,
+    ecb_detect_result *top, size_t top_cap, size_t *top_len,
+    size_t *skipped)
+{
+	if (!corpus || !top || top_cap == 0 || !top_len) {
+		return ECB_DETECT_ERR_ARGS;
+	}
+	if (threads == 0) {
+		threads = xor_scan_default_threads();
+	}
+
+	arena *scratch = arena_scratch();
+	if (!scratch) {
+		return ECB_DETECT_ERR_OOM;
+	}
+	arena_mark mark = arena_save(scratch);
+	ecb_detect_worker *workers = arena_calloc(scratch, threads,
+	    sizeof(*workers));
+	pthread_t *tids = arena_calloc(scratch, threads, sizeof(*tids));
+	if (!workers || !tids) {
+		arena_restore(scratch, mark);
+		return ECB_DETECT_ERR_OOM;
+	}
+
+	ecb_detect_status status = ECB_DETECT_OK;
+	for (size_t t = 0; t < threads; ++t) {
+		hex_corpus_shard(corpus, t, threads, &workers[t].cursor);
+		ecb_detect_result *items = arena_calloc(scratch, top_cap,
+		    sizeof(ecb_detect_result));
+		if (!items) {
+			status = ECB_DETECT_ERR_OOM;
+		}
+		corpus_scan_heap_init(&workers[t].heap, items, top_cap,
+		    sizeof(ecb_detect_result), ecb_detect_worse);
+	}
+
+	if (status == ECB_DETECT_OK && corpus_scan_run_workers(workers,
+		sizeof(*workers), threads, tids, ecb_detect_worker_run) != 0) {
+		status = ECB_DETECT_ERR_THREAD;
+	}
+
+	// Reduce: fold every worker heap into the first one.
+	size_t total_skipped = 0;
+	for (size_t t = 0; t < threads && status == ECB_DETECT_OK; ++t) {
+		if (workers[t].status != ECB_DETECT_OK) {
+			status = workers[t].status;
+			break;
+		}
+		total_skipped += workers[t].skipped;
+		if (t > 0) {
+			corpus_scan_heap_merge(&workers[0].heap,
+			    &workers[t].heap);
+		}
+	}
+
+	if (status == ECB_DETECT_OK) {
+		corpus_scan_heap *best = &workers[0].heap;
+		corpus_scan_number_lines(best, corpus,
+		    offsetof(ecb_detect_result, hex),
+		    offsetof(ecb_detect_result, line));
+		corpus_scan_heap_sort(best);
+		memcpy(top, best->items, best->len * sizeof(ecb_detect_result));
+		*top_len = best->len;
+		if (skipped) {
+			*skipped = total_skipped;
+		}
+	}
+
+	arena_restore(scratch, mark);
+	return status;
+}
@@ -11,9 +11,27 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "cpu_features.h"
+#include "stats.h"
+
+#if CPU_FEATURES_X86
+#include <immintrin.h>
+#endif
 
 #define FIXED_XOR_CHUNK 4096
 
+/**
+ * @brief Bytes per input processed in each step of the streaming paths.
+ *
+ * Both blocks are allocated once per call rather than placed on the stack,
+ * so the stream functions are safe on small worker-thread stacks.
+ */
+#define FIXED_XOR_BLOCK 65536
+
 static int fixed_xor_force_oom = 0;
 
 void
@@ -22,19 +40,142 @@ fixed_xor_set_allocation_failure(int enable)
 	fixed_xor_force_oom = enable;
 }
 
+/** @brief Portable kernel: eight bytes per step, then a byte tail. */
+static void
+fixed_xor_scalar(const uint8_t *lhs, const uint8_t *rhs, uint8_t *out,
+    size_t len)
+{
+	size_t i = 0;
+	for (; i + 8 <= len; i += 8) {
+		uint64_t a, b;
+		memcpy(&a, lhs + i, sizeof(a));
+		memcpy(&b, rhs + i, sizeof(b));
+		a ^= b;
+		memcpy(out + i, &a, sizeof(a));
+	}
+	for (; i < len; ++i) {
+		out[i] = lhs[i] ^ rhs[i];
+	}
+}
+
+#if CPU_FEATURES_X86
+/*
+ * Vector kernels load both inputs unaligned and store with aligned stores;
+ * the dispatcher aligns @p out to the widest width in use first. Each one
+ * returns the number of bytes handled, a multiple of its width.
+ */
+
+/** @brief SSE2 kernel: 16 bytes per step. */
+__attribute__((target("sse2")))
+static size_t
+fixed_xor_sse2(const uint8_t *lhs, const uint8_t *rhs, uint8_t *out,
+    size_t len)
+{
+	size_t i = 0;
+	for (; i + 64 <= len; i += 64) {
+		for (size_t j = 0; j < 64; j += 16) {
+			__m128i a = _mm_loadu_si128((const __m128i *)
+			    (lhs + i + j));
+			__m128i b = _mm_loadu_si128((const __m128i *)
+			    (rhs + i + j));
+			_mm_store_si128((__m128i *) (out + i + j),
+			    _mm_xor_si128(a, b));
+		}
+	}
+	for (; i + 16 <= len; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i *) (lhs + i));
+		__m128i b = _mm_loadu_si128((const __m128i *) (rhs + i));
+		_mm_store_si128((__m128i *) (out + i), _mm_xor_si128(a, b));
+	}
+	return i;
+}
+
+/** @brief AVX2 kernel: 32 bytes per step. */
+__attribute__((target("avx2")))
+static size_t
+fixed_xor_avx2(const uint8_t *lhs, const uint8_t *rhs, uint8_t *out,
+    size_t len)
+{
+	size_t i = 0;
+	for (; i + 128 <= len; i += 128) {
+		for (size_t j = 0; j < 128; j += 32) {
+			__m256i a = _mm256_loadu_si256((const __m256i *)
+			    (lhs + i + j));
+			__m256i b = _mm256_loadu_si256((const __m256i *)
+			    (rhs + i + j));
+			_mm256_store_si256((__m256i *) (out + i + j),
+			    _mm256_xor_si256(a, b));
+		}
+	}
+	for (; i + 32 <= len; i += 32) {
+		__m256i a = _mm256_loadu_si256((const __m256i *) (lhs + i));
+		__m256i b = _mm256_loadu_si256((const __m256i *) (rhs + i));
+		_mm256_store_si256((__m256i *) (out + i),
+		    _mm256_xor_si256(a, b));
+	}
+	return i;
+}
+
+/** @brief AVX-512 kernel: 64 bytes per step. */
+__attribute__((target("avx512f")))
+static size_t
+fixed_xor_avx512(const uint8_t *lhs, const uint8_t *rhs, uint8_t *out,
+    size_t len)
+{
+	size_t i = 0;
+	for (; i + 256 <= len; i += 256) {
+		for (size_t j = 0; j < 256; j += 64) {
+			__m512i a = _mm512_loadu_si512(lhs + i + j);
+			__m512i b = _mm512_loadu_si512(rhs + i + j);
+			_mm512_store_si512(out + i + j,
+			    _mm512_xor_si512(a, b));
+		}
+	}
+	for (; i + 64 <= len; i += 64) {
+		__m512i a = _mm512_loadu_si512(lhs + i);
+		__m512i b = _mm512_loadu_si512(rhs + i);
+		_mm512_store_si512(out + i, _mm512_xor_si512(a, b));
+	}
+	return i;
+}
+#endif
+
 /** @brief Implementation of fixed_xor_buffers(). */
 fixed_xor_status
 fixed_xor_buffers(const uint8_t *lhs,
     const uint8_t *rhs, uint8_t *out, size_t len)
 {
+	STATS_SCOPE(STATS_FIXED_XOR, len);
+
 	if (!lhs || !rhs || !out) {
 		errno = EINVAL;
 		return FIXED_XOR_ERR_ARGS;
 	}
 
-	for (size_t i = 0; i < len; ++i) {
-		out[i] = lhs[i] ^ rhs[i];
+	size_t i = 0;
+#if CPU_FEATURES_X86
+	unsigned features = cpu_features();
+	size_t width = features & CPU_FEATURE_AVX512F ? 64 :
+	    features & CPU_FEATURE_AVX2 ? 32 :
+	    features & CPU_FEATURE_SSE2 ? 16 : 0;
+	if (width != 0 && len >= 2 * width) {
+		// Peel bytes until the stores are aligned, then let each
+		// narrower kernel take what the wider one left over.
+		i = (width - ((uintptr_t) out & (width - 1))) & (width - 1);
+		fixed_xor_scalar(lhs, rhs, out, i);
+		if (features & CPU_FEATURE_AVX512F) {
+			i += fixed_xor_avx512(lhs + i, rhs + i, out + i,
+			    len - i);
+		}
+		if (features & CPU_FEATURE_AVX2) {
+			i += fixed_xor_avx2(lhs + i, rhs + i, out + i, len - i);
+		}
+		if (features & CPU_FEATURE_SSE2) {
+			i += fixed_xor_sse2(lhs + i, rhs + i, out + i, len - i);
+		}
 	}
+#endif
+	fixed_xor_scalar(lhs + i, rhs + i, out + i, len - i);
 
 	return FIXED_XOR_OK;
 }
@@ -76,6 +217,79 @@ fixed_xor_grow(uint8_t **buffer, size_t *capacity, size_t required)
 	return FIXED_XOR_OK;
 }
 
+/**
+ * @brief Read exactly @p len bytes at @p offset, retrying short reads.
+ *
+ * @return Non-zero on success, zero on error or premature end of file.
+ */
+static int
+fixed_xor_pread_full(int fd, uint8_t *buf, size_t len, off_t offset)
+{
+	while (len > 0) {
+		ssize_t n = pread(fd, buf, len, offset);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return 0;
+		}
+		buf += n;
+		len -= (size_t) n;
+		offset += n;
+	}
+	return 1;
+}
+
+/**
+ * @brief Split a regular file's remaining bytes in half with pread().
+ *
+ * @param in     Stream whose descriptor is read; left positioned at EOF.
+ * @param start  Logical stream position where the first half begins.
+ * @param length Number of bytes remaining from @p start.
+ * @param out    Stream that receives XOR output.
+ * @return FIXED_XOR_OK on success or an error status on failure.
+ */
+static fixed_xor_status
+fixed_xor_stream_split(FILE *in, off_t start, off_t length, FILE *out)
+{
+	if (length % 2 != 0) {
+		return FIXED_XOR_ERR_ODD_INPUT;
+	}
+
+	int fd = fileno(in);
+	off_t half = length / 2;
+	uint8_t *lhs = malloc(2 * FIXED_XOR_BLOCK);
+	if (!lhs) {
+		return FIXED_XOR_ERR_OOM;
+	}
+	uint8_t *rhs = lhs + FIXED_XOR_BLOCK;
+
+	fixed_xor_status status = FIXED_XOR_OK;
+	for (off_t done = 0; done < half;) {
+		size_t n = half - done < FIXED_XOR_BLOCK ?
+		    (size_t) (half - done) : FIXED_XOR_BLOCK;
+		if (!fixed_xor_pread_full(fd, lhs, n, start + done) ||
+		    !fixed_xor_pread_full(fd, rhs, n, start + half + done)) {
+			status = FIXED_XOR_ERR_IO;
+			break;
+		}
+		fixed_xor_buffers(lhs, rhs, lhs, n);
+		if (fwrite(lhs, 1, n, out) != n) {
+			status = FIXED_XOR_ERR_IO;
+			break;
+		}
+		done += (off_t) n;
+	}
+	free(lhs);
+
+	// Leave the stream where a sequential reader would have.
+	if (status == FIXED_XOR_OK &&
+	    fseeko(in, start + length, SEEK_SET) != 0) {
+		status = FIXED_XOR_ERR_IO;
+	}
+	return status;
+}
+
 /** @brief Implementation of fixed_xor_stream(). */
 fixed_xor_status
 fixed_xor_stream(FILE *in, FILE *out)
@@ -84,8 +298,13 @@ fixed_xor_stream(FILE *in, FILE *out)
 		errno = EINVAL;
 		return FIXED_XOR_ERR_ARGS;
 	}
-	if (fixed_xor_force_oom) {
-		return FIXED_XOR_ERR_OOM;
+
+	struct stat st;
+	off_t start = ftello(in);
+	if (start >= 0 && fstat(fileno(in), &st) == 0 &&
+	    S_ISREG(st.st_mode)) {
+		off_t length = st.st_size > start ? st.st_size - start : 0;
+		return fixed_xor_stream_split(in, start, length, out);
 	}
 
 	size_t capacity = FIXED_XOR_CHUNK;
@@ -139,6 +358,52 @@ fixed_xor_stream(FILE *in, FILE *out)
 	return FIXED_XOR_OK;
 }
 
+/** @brief Implementation of fixed_xor_stream_pair(). */
+fixed_xor_status
+fixed_xor_stream_pair(FILE *lhs, FILE *rhs, FILE *out)
+{
+	if (!lhs || !rhs || !out) {
+		errno = EINVAL;
+		return FIXED_XOR_ERR_ARGS;
+	}
+
+	uint8_t *lbuf = malloc(2 * FIXED_XOR_BLOCK);
+	if (!lbuf) {
+		return FIXED_XOR_ERR_OOM;
+	}
+	uint8_t *rbuf = lbuf + FIXED_XOR_BLOCK;
+
+	fixed_xor_status status;
+	for (;;) {
+		// fread() only comes up short at end of file or on error, so
+		// equal-length inputs always yield equal counts.
+		size_t ln = fread(lbuf, 1, FIXED_XOR_BLOCK, lhs);
+		size_t rn = fread(rbuf, 1, FIXED_XOR_BLOCK, rhs);
+		size_t n = ln < rn ? ln : rn;
+
+		fixed_xor_buffers(lbuf, rbuf, lbuf, n);
+		if (fwrite(lbuf, 1, n, out) != n) {
+			status = FIXED_XOR_ERR_IO;
+			break;
+		}
+		if (ferror(lhs) || ferror(rhs)) {
+			status = FIXED_XOR_ERR_IO;
+			break;
+		}
+		if (ln != rn) {
+			status = FIXED_XOR_ERR_LENGTH_MISMATCH;
+			break;
+		}
+		if (ln < FIXED_XOR_BLOCK) {
+			status = FIXED_XOR_OK;
+			break;
+		}
+	}
+
+	free(lbuf);
+	return status;
+}
+
 /** @brief Implementation of fixed_xor_status_string(). */
 const char *
 fixed_xor_status_string(fixed_xor_status status)
@@ -154,6 +419,8 @@ fixed_xor_status_string(fixed_xor_status status)
 		return "input length must be even (two equal buffers)";
 	case FIXED_XOR_ERR_OOM:
 		return "out of memory";
+	case FIXED_XOR_ERR_LENGTH_MISMATCH:
+		return "inputs differ in length";
 	default:
 		return "unknown error";
 	}
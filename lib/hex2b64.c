@@ -5,12 +5,19 @@
 
 #include "hex2b64.h"
 
-#include <ctype.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
+#include "arena.h"
+#include "cpu_features.h"
+#include "stats.h"
 #include "utils.h"
 
+#if CPU_FEATURES_X86
+#include <immintrin.h>
+#endif
+
 static const char b64_table[] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZ" "abcdefghijklmnopqrstuvwxyz" "0123456789+/";
 
@@ -30,6 +37,8 @@ hex2b64_status_string(hex2b64_status status)
 		return "output buffer too small";
 	case HEX2B64_ERR_IO:
 		return "input/output failure";
+	case HEX2B64_ERR_OOM:
+		return "out of memory";
 	default:
 		return "unknown hex2b64 error";
 	}
@@ -54,153 +63,380 @@ encode_base64_chars(const uint8_t *in, size_t len, char encoded[4])
 	encoded[3] = (len > 2) ? b64_table[triple & 0x3F] : '=';
 }
 
-static hex2b64_status
-encode_base64_block(const uint8_t *in, size_t len, FILE *out)
+#if CPU_FEATURES_X86
+/*
+ * Vector encoders after Muła and Lemire, "Faster Base64 Encoding and
+ * Decoding using AVX2 Instructions". Each 32-bit lane receives one 3-byte
+ * group shuffled as [b1 b0 b2 b1]; two multiplies move the four 6-bit
+ * indices into separate bytes, and a pshufb over a 16-entry offset table
+ * (selected by index range) turns indices into ASCII.
+ */
+
+__attribute__((target("ssse3")))
+static inline __m128i
+base64_ascii_ssse3(__m128i indices)
 {
-	char encoded[4];
-	encode_base64_chars(in, len, encoded);
+	__m128i reduced = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+	__m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+	reduced = _mm_or_si128(reduced,
+	    _mm_and_si128(less, _mm_set1_epi8(13)));
+	const __m128i shift = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52,
+	    '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+	    '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+	return _mm_add_epi8(_mm_shuffle_epi8(shift, reduced), indices);
+}
 
-	for (int i = 0; i < 4; ++i) {
-		if (fputc(encoded[i], out) == EOF) {
-			return HEX2B64_ERR_IO;
-		}
+__attribute__((target("ssse3")))
+static inline __m128i
+base64_indices_ssse3(__m128i in)
+{
+	in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7,
+		4, 5, 3, 4, 1, 2, 0, 1));
+	__m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+	__m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+	__m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+	__m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+	return _mm_or_si128(t1, t3);
+}
+
+/** @brief SSSE3 encoder: 12 bytes to 16 characters per iteration. */
+__attribute__((target("ssse3")))
+static size_t
+encode_base64_ssse3(const uint8_t *in, size_t len, uint8_t *out)
+{
+	size_t i = 0;
+	size_t o = 0;
+	// Each load reads 16 bytes but consumes 12.
+	for (; i + 16 <= len; i += 12, o += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *) (in + i));
+		_mm_storeu_si128((__m128i *) (out + o),
+		    base64_ascii_ssse3(base64_indices_ssse3(v)));
 	}
+	return i;
+}
 
-	return HEX2B64_OK;
+/** @brief AVX2 encoder: 24 bytes to 32 characters per iteration. */
+__attribute__((target("avx2")))
+static size_t
+encode_base64_avx2(const uint8_t *in, size_t len, uint8_t *out)
+{
+	const __m256i shuffle = _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7,
+	    4, 5, 3, 4, 1, 2, 0, 1, 10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4,
+	    1, 2, 0, 1);
+	const __m256i shift = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52,
+	    '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+	    '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+	    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+	    '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+	    '/' - 63, 'A', 0, 0);
+
+	size_t i = 0;
+	size_t o = 0;
+	// Lane 0 takes bytes 0-11 and lane 1 bytes 12-23; the second 16-byte
+	// load reads up to 4 bytes past the group.
+	for (; i + 28 <= len; i += 24, o += 32) {
+		__m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(
+			_mm_loadu_si128((const __m128i *) (in + i))),
+		    _mm_loadu_si128((const __m128i *) (in + i + 12)), 1);
+		v = _mm256_shuffle_epi8(v, shuffle);
+		__m256i t0 = _mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00));
+		__m256i t1 = _mm256_mulhi_epu16(t0,
+		    _mm256_set1_epi32(0x04000040));
+		__m256i t2 = _mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0));
+		__m256i t3 = _mm256_mullo_epi16(t2,
+		    _mm256_set1_epi32(0x01000010));
+		__m256i indices = _mm256_or_si256(t1, t3);
+
+		__m256i reduced = _mm256_subs_epu8(indices,
+		    _mm256_set1_epi8(51));
+		__m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+		reduced = _mm256_or_si256(reduced,
+		    _mm256_and_si256(less, _mm256_set1_epi8(13)));
+		__m256i ascii = _mm256_add_epi8(
+		    _mm256_shuffle_epi8(shift, reduced), indices);
+		_mm256_storeu_si256((__m256i *) (out + o), ascii);
+	}
+	return i;
+}
+#endif
+
+/**
+ * @brief Encode every complete 3-byte group of @p in into @p out.
+ *
+ * The widest available vector kernel handles the bulk and the scalar
+ * encoder finishes the remaining groups.
+ *
+ * @return Number of input bytes consumed (a multiple of 3).
+ */
+static size_t
+encode_base64_groups(const uint8_t *in, size_t len, uint8_t *out)
+{
+	STATS_SCOPE(STATS_BASE64_ENCODE, len);
+
+	size_t done = 0;
+#if CPU_FEATURES_X86
+	unsigned features = cpu_features();
+	if (features & CPU_FEATURE_AVX2) {
+		done = encode_base64_avx2(in, len, out);
+	}
+	if (features & CPU_FEATURE_SSSE3) {
+		done += encode_base64_ssse3(in + done, len - done,
+		    out + done / 3 * 4);
+	}
+#endif
+	size_t groups = len / 3;
+	for (size_t g = done / 3; g < groups; ++g) {
+		encode_base64_chars(in + 3 * g, 3, (char *) out + 4 * g);
+	}
+	return groups * 3;
 }
 
 hex2b64_status
-hex2b64_stream(FILE *in, FILE *out)
+bytes_to_base64(const uint8_t *bytes, size_t len, uint8_t *out,
+    size_t out_cap, size_t *out_len)
 {
-	if (!in || !out) {
+	if ((!bytes && len > 0) || (!out && out_cap > 0)) {
 		return HEX2B64_ERR_ARGS;
 	}
 
-	int ch;
-	int high_nibble = -1;
-	uint8_t buffer[3];
-	size_t buf_len = 0;
+	size_t needed = (len + 2) / 3 * 4;
+	if (len > SIZE_MAX / 4 * 3 - 2 || needed > out_cap) {
+		return HEX2B64_ERR_OUTPUT_OVERFLOW;
+	}
 
-	while ((ch = fgetc(in)) != EOF) {
-		if (isspace((unsigned char) ch)) {
-			continue;
-		}
+	size_t used = encode_base64_groups(bytes, len, out);
+	if (used < len) {
+		encode_base64_chars(bytes + used, len - used,
+		    (char *) out + used / 3 * 4);
+	}
 
-		int v = hex_digit_value(ch);
-		if (v < 0) {
-			return HEX2B64_ERR_INVALID_HEX;
-		}
+	if (out_len) {
+		*out_len = needed;
+	}
+	return HEX2B64_OK;
+}
 
-		if (high_nibble < 0) {
-			high_nibble = v;
-		} else {
-			uint8_t byte = (uint8_t) ((high_nibble << 4) | v);
-			high_nibble = -1;
-			buffer[buf_len++] = byte;
-
-			if (buf_len == 3) {
-				hex2b64_status status =
-				    encode_base64_block(buffer, buf_len, out);
-				if (status != HEX2B64_OK) {
-					return status;
-				}
-				buf_len = 0;
-			}
+/** @brief Input hex characters handled per conversion block. */
+#define HEX2B64_BLOCK 16384
+
+/**
+ * @brief Where converted Base64 goes: a FILE or a bounded memory buffer.
+ */
+typedef struct
+{
+	FILE *file;
+	uint8_t *buf;
+	size_t cap;
+	size_t len;
+} hex2b64_sink;
+
+/**
+ * @brief Block-wise hex-to-Base64 converter shared by the stream and
+ * buffer entry points.
+ *
+ * About 35 KB, so it is taken from the scratch arena rather than the
+ * stack, which may be small on worker threads.
+ */
+typedef struct
+{
+	// One carried digit plus a block of digits.
+	char digits[HEX2B64_BLOCK + 1];
+	size_t ndigits;
+	// Up to two carried bytes plus the decoded block.
+	uint8_t bytes[HEX2B64_BLOCK / 2 + 3];
+	size_t nbytes;
+	uint8_t encoded[(HEX2B64_BLOCK / 2 + 3) / 3 * 4 + 1];
+	hex2b64_sink *sink;
+} hex2b64_converter;
+
+static hex2b64_status
+hex2b64_sink_write(hex2b64_sink *sink, const uint8_t *data, size_t len)
+{
+	if (sink->file) {
+		return fwrite(data, 1, len, sink->file) == len ?
+		    HEX2B64_OK : HEX2B64_ERR_IO;
+	}
+	if (len > sink->cap - sink->len) {
+		// Keep the whole groups that fit, as a group-at-a-time
+		// writer would have.
+		size_t fit = (sink->cap - sink->len) / 4 * 4;
+		memcpy(sink->buf + sink->len, data, fit);
+		sink->len += fit;
+		return HEX2B64_ERR_OUTPUT_OVERFLOW;
+	}
+	memcpy(sink->buf + sink->len, data, len);
+	sink->len += len;
+	return HEX2B64_OK;
+}
+
+/**
+ * @brief Whitespace accepted between hex digits; the C-locale isspace() set.
+ */
+static int
+hex2b64_is_space(uint8_t ch)
+{
+	return ch == ' ' || (ch >= '\t' && ch <= '\r');
+}
+
+/**
+ * @brief Convert up to HEX2B64_BLOCK input characters.
+ *
+ * Whitespace is dropped, whole digit pairs are decoded in bulk and every
+ * complete 3-byte group is encoded and written. An odd digit and up to two
+ * leftover bytes are carried into the next call.
+ *
+ * On an invalid digit the groups before it are still written, so the
+ * output matches a digit-by-digit conversion that stops at the bad digit.
+ */
+static hex2b64_status
+hex2b64_convert_block(hex2b64_converter *c, const uint8_t *in, size_t len)
+{
+	for (size_t i = 0; i < len; ++i) {
+		if (!hex2b64_is_space(in[i])) {
+			c->digits[c->ndigits++] = (char) in[i];
 		}
 	}
 
-	if (ferror(in)) {
-		return HEX2B64_ERR_IO;
+	size_t even = c->ndigits & ~(size_t) 1;
+	hex2b64_status status = HEX2B64_OK;
+	if (hex_to_bytes_n(c->digits, even, c->bytes + c->nbytes,
+		sizeof(c->bytes) - c->nbytes, NULL) != UTILS_OK) {
+		// Rare path: rescan for the bad digit and keep only the pairs
+		// before it.
+		size_t bad = 0;
+		while (hex_digit_value((unsigned char) c->digits[bad]) >= 0) {
+			bad++;
+		}
+		even = bad & ~(size_t) 1;
+		hex_to_bytes_n(c->digits, even, c->bytes + c->nbytes,
+		    sizeof(c->bytes) - c->nbytes, NULL);
+		c->ndigits = even;
+		status = HEX2B64_ERR_INVALID_HEX;
+	}
+	c->nbytes += even / 2;
+	if (c->ndigits & 1U) {
+		c->digits[0] = c->digits[c->ndigits - 1];
 	}
+	c->ndigits &= 1U;
+
+	size_t used = encode_base64_groups(c->bytes, c->nbytes, c->encoded);
+	hex2b64_status write_status =
+	    hex2b64_sink_write(c->sink, c->encoded, used / 3 * 4);
+	memmove(c->bytes, c->bytes + used, c->nbytes - used);
+	c->nbytes -= used;
+	// A failed write happened earlier in the input than the bad digit.
+	return write_status != HEX2B64_OK ? write_status : status;
+}
 
-	if (high_nibble >= 0) {
+/**
+ * @brief Flush the final partial group (with padding) and the newline.
+ */
+static hex2b64_status
+hex2b64_finish(hex2b64_converter *c)
+{
+	if (c->ndigits > 0) {
+		if (hex_digit_value((unsigned char) c->digits[0]) < 0) {
+			return HEX2B64_ERR_INVALID_HEX;
+		}
 		return HEX2B64_ERR_ODD_DIGITS;
 	}
 
-	if (buf_len > 0) {
+	if (c->nbytes > 0) {
+		encode_base64_chars(c->bytes, c->nbytes, (char *) c->encoded);
 		hex2b64_status status =
-		    encode_base64_block(buffer, buf_len, out);
+		    hex2b64_sink_write(c->sink, c->encoded, 4);
 		if (status != HEX2B64_OK) {
 			return status;
 		}
 	}
-
-	if (fputc('\n', out) == EOF) {
-		return HEX2B64_ERR_IO;
-	}
-
-	return HEX2B64_OK;
+	c->encoded[0] = '\n';
+	return hex2b64_sink_write(c->sink, c->encoded, 1);
 }
 
 hex2b64_status
-hex2b64_buffer(const uint8_t *hex,
-    size_t hex_len, uint8_t *out, size_t out_cap, size_t *out_len)
+hex2b64_stream(FILE *in, FILE *out)
 {
-	if (!out || (!hex && hex_len > 0)) {
+	if (!in || !out) {
 		return HEX2B64_ERR_ARGS;
 	}
 
-	uint8_t buffer[3];
-	size_t buf_len = 0;
-	int high_nibble = -1;
-	size_t produced = 0;
+	arena *scratch = arena_scratch();
+	if (!scratch) {
+		return HEX2B64_ERR_OOM;
+	}
+	arena_mark mark = arena_save(scratch);
+	uint8_t *block = arena_alloc(scratch, HEX2B64_BLOCK, ARENA_MAX_ALIGN);
+	hex2b64_converter *converter = arena_alloc(scratch,
+	    sizeof(*converter), ARENA_MAX_ALIGN);
+	if (!block || !converter) {
+		arena_restore(scratch, mark);
+		return HEX2B64_ERR_OOM;
+	}
 
-	for (size_t i = 0; i < hex_len; ++i) {
-		uint8_t ch = hex[i];
-		if (isspace((unsigned char) ch)) {
-			continue;
-		}
+	hex2b64_sink sink = { out, NULL, 0, 0 };
+	converter->ndigits = 0;
+	converter->nbytes = 0;
+	converter->sink = &sink;
 
-		int v = hex_digit_value(ch);
-		if (v < 0) {
-			return HEX2B64_ERR_INVALID_HEX;
+	hex2b64_status status = HEX2B64_OK;
+	size_t nread;
+	while ((nread = fread(block, 1, HEX2B64_BLOCK, in)) > 0) {
+		status = hex2b64_convert_block(converter, block, nread);
+		if (status != HEX2B64_OK) {
+			break;
 		}
+	}
 
-		if (high_nibble < 0) {
-			high_nibble = v;
-		} else {
-			uint8_t byte = (uint8_t) ((high_nibble << 4) | v);
-			high_nibble = -1;
-			buffer[buf_len++] = byte;
-
-			if (buf_len == 3) {
-				if (produced + 4 > out_cap) {
-					return HEX2B64_ERR_OUTPUT_OVERFLOW;
-				}
-				char encoded[4];
-				encode_base64_chars(buffer, buf_len, encoded);
-				out[produced++] = (uint8_t) encoded[0];
-				out[produced++] = (uint8_t) encoded[1];
-				out[produced++] = (uint8_t) encoded[2];
-				out[produced++] = (uint8_t) encoded[3];
-				buf_len = 0;
-			}
-		}
+	if (status == HEX2B64_OK) {
+		status = ferror(in) ? HEX2B64_ERR_IO :
+		    hex2b64_finish(converter);
 	}
+	arena_restore(scratch, mark);
+	return status;
+}
 
-	if (high_nibble >= 0) {
-		return HEX2B64_ERR_ODD_DIGITS;
+hex2b64_status
+hex2b64_buffer(const uint8_t *hex,
+    size_t hex_len, uint8_t *out, size_t out_cap, size_t *out_len)
+{
+	if (!out || (!hex && hex_len > 0)) {
+		return HEX2B64_ERR_ARGS;
 	}
 
-	if (buf_len > 0) {
-		if (produced + 4 > out_cap) {
-			return HEX2B64_ERR_OUTPUT_OVERFLOW;
-		}
-		char encoded[4];
-		encode_base64_chars(buffer, buf_len, encoded);
-		out[produced++] = (uint8_t) encoded[0];
-		out[produced++] = (uint8_t) encoded[1];
-		out[produced++] = (uint8_t) encoded[2];
-		out[produced++] = (uint8_t) encoded[3];
+	arena *scratch = arena_scratch();
+	if (!scratch) {
+		return HEX2B64_ERR_OOM;
+	}
+	arena_mark mark = arena_save(scratch);
+	hex2b64_converter *converter = arena_alloc(scratch,
+	    sizeof(*converter), ARENA_MAX_ALIGN);
+	if (!converter) {
+		arena_restore(scratch, mark);
+		return HEX2B64_ERR_OOM;
 	}
 
-	if (produced + 1 > out_cap) {
-		return HEX2B64_ERR_OUTPUT_OVERFLOW;
+	hex2b64_sink sink = { NULL, out, out_cap, 0 };
+	converter->ndigits = 0;
+	converter->nbytes = 0;
+	converter->sink = &sink;
+
+	hex2b64_status status = HEX2B64_OK;
+	for (size_t off = 0; off < hex_len && status == HEX2B64_OK;
+	    off += HEX2B64_BLOCK) {
+		size_t chunk = hex_len - off < HEX2B64_BLOCK ?
+		    hex_len - off : HEX2B64_BLOCK;
+		status = hex2b64_convert_block(converter, hex + off, chunk);
+	}
+	if (status == HEX2B64_OK) {
+		status = hex2b64_finish(converter);
+	}
+	arena_restore(scratch, mark);
+	if (status != HEX2B64_OK) {
+		return status;
 	}
-	out[produced++] = '\n';
 
 	if (out_len) {
-		*out_len = produced;
+		*out_len = sink.len;
 	}
 
 	return HEX2B64_OK;
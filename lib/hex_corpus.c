@@ -0,0 +1,168 @@
+/**
+ * @file hex_corpus.c
+ * @brief Implementation of the memory-mapped hex corpus reader.
+ */
+
+#include "hex_corpus.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char *
+hex_corpus_status_string(hex_corpus_status status)
+{
+	switch (status) {
+	case HEX_CORPUS_OK:
+		return "success";
+	case HEX_CORPUS_ERR_ARGS:
+		return "invalid arguments";
+	case HEX_CORPUS_ERR_IO:
+		return "input/output failure";
+	default:
+		return "unknown hex_corpus error";
+	}
+}
+
+hex_corpus_status
+hex_corpus_open(const char *path, hex_corpus *corpus)
+{
+	if (!path || !corpus) {
+		return HEX_CORPUS_ERR_ARGS;
+	}
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return HEX_CORPUS_ERR_IO;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+		close(fd);
+		return HEX_CORPUS_ERR_IO;
+	}
+
+	corpus->data = NULL;
+	corpus->size = (size_t) st.st_size;
+	corpus->mapped = 0;
+
+	// mmap() rejects zero-length mappings; an empty file is an empty corpus.
+	if (corpus->size > 0) {
+		void *map = mmap(NULL, corpus->size, PROT_READ, MAP_PRIVATE,
+		    fd, 0);
+		if (map == MAP_FAILED) {
+			close(fd);
+			return HEX_CORPUS_ERR_IO;
+		}
+		// Lines are consumed front to back exactly once.
+		madvise(map, corpus->size, MADV_SEQUENTIAL);
+		corpus->data = map;
+		corpus->mapped = 1;
+	}
+
+	close(fd);
+	return HEX_CORPUS_OK;
+}
+
+hex_corpus_status
+hex_corpus_from_buffer(const char *data, size_t size, hex_corpus *corpus)
+{
+	if ((!data && size > 0) || !corpus) {
+		return HEX_CORPUS_ERR_ARGS;
+	}
+
+	corpus->data = data;
+	corpus->size = size;
+	corpus->mapped = 0;
+	return HEX_CORPUS_OK;
+}
+
+void
+hex_corpus_close(hex_corpus *corpus)
+{
+	if (!corpus) {
+		return;
+	}
+	if (corpus->mapped) {
+		munmap((void *) corpus->data, corpus->size);
+	}
+	corpus->data = NULL;
+	corpus->size = 0;
+	corpus->mapped = 0;
+}
+
+/**
+ * @brief Return the first line start at or after byte @p offset.
+ */
+static const char *
+hex_corpus_line_start(const hex_corpus *corpus, size_t offset)
+{
+	const char *end = corpus->data + corpus->size;
+	if (offset == 0) {
+		return corpus->data;
+	}
+	if (offset >= corpus->size) {
+		return end;
+	}
+
+	const char *p = corpus->data + offset;
+	if (p[-1] == '\n') {
+		return p;
+	}
+	const char *nl = memchr(p, '\n', (size_t) (end - p));
+	return nl ? nl + 1 : end;
+}
+
+void
+hex_corpus_shard(const hex_corpus *corpus, size_t index, size_t count,
+    hex_corpus_cursor *cursor)
+{
+	if (!corpus || !cursor || count == 0 || index >= count ||
+	    corpus->size == 0) {
+		if (cursor) {
+			cursor->pos = cursor->stop = cursor->end = NULL;
+		}
+		return;
+	}
+
+	// Split in two steps so size * index cannot overflow.
+	size_t step = corpus->size / count;
+	size_t extra = corpus->size % count;
+	size_t begin = step * index + (extra * index) / count;
+	size_t stop = step * (index + 1) + (extra * (index + 1)) / count;
+
+	cursor->pos = hex_corpus_line_start(corpus, begin);
+	cursor->stop = hex_corpus_line_start(corpus, stop);
+	cursor->end = corpus->data + corpus->size;
+}
+
+int
+hex_corpus_next(hex_corpus_cursor *cursor, hex_corpus_line *line)
+{
+	if (!cursor || !line) {
+		return 0;
+	}
+
+	while (cursor->pos && cursor->pos < cursor->stop) {
+		const char *start = cursor->pos;
+		const char *nl = memchr(start, '\n',
+		    (size_t) (cursor->end - start));
+		const char *stop = nl ? nl : cursor->end;
+		cursor->pos = nl ? nl + 1 : cursor->end;
+
+		size_t len = (size_t) (stop - start);
+		if (len > 0 && start[len - 1] == '\r') {
+			len--;
+		}
+		if (len == 0) {
+			continue;
+		}
+
+		line->data = start;
+		line->len = len;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,358 @@
+/**
+ * @file repeat_xor.c
+ * @brief Implementation of repeating-key XOR.
+ *
+ * Short keys are replicated into a pattern whose period is a whole number of
+ * keys, so every step is a single fixed_xor_buffers() call against the
+ * pattern at the current key offset and the SIMD kernels never see a key
+ * boundary. Long keys are applied a segment at a time straight from the
+ * caller's buffer.
+ *
+ * The breaker ranks key sizes by normalized Hamming distance and solves
+ * each key byte's column with the single-byte histogram solver from utils.
+ */
+
+#include "repeat_xor.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "corpus_scan.h"
+#include "fixed_xor.h"
+#include "hamming.h"
+#include "stats.h"
+#include "utils.h"
+#include "xor_scan.h"
+
+/**
+ * @brief Most memory repeat_xor_break() spends on per-worker column
+ * histograms; the worker count is lowered to stay within it.
+ */
+#define REPEAT_XOR_HIST_BUDGET (64u * 1024u * 1024u)
+
+const char *
+repeat_xor_status_string(repeat_xor_status status)
+{
+	switch (status) {
+	case REPEAT_XOR_OK:
+		return "success";
+	case REPEAT_XOR_ERR_ARGS:
+		return "invalid arguments";
+	case REPEAT_XOR_ERR_TOO_SHORT:
+		return "ciphertext too short for the key sizes";
+	case REPEAT_XOR_ERR_OOM:
+		return "out of memory";
+	case REPEAT_XOR_ERR_THREAD:
+		return "failed to start worker thread";
+	case REPEAT_XOR_ERR_SCORE_FAIL:
+		return "column scoring failed";
+	default:
+		return "unknown repeat_xor error";
+	}
+}
+
+repeat_xor_status
+repeat_xor_init(repeat_xor_ctx *ctx, const uint8_t *key, size_t key_len)
+{
+	if (!ctx || !key || key_len == 0) {
+		return REPEAT_XOR_ERR_ARGS;
+	}
+
+	ctx->key = key;
+	ctx->key_len = key_len;
+	ctx->offset = 0;
+	ctx->period = 0;
+	if (key_len > REPEAT_XOR_PERIOD) {
+		return REPEAT_XOR_OK;
+	}
+
+	// A step may start anywhere in the first key copy, so keep one extra
+	// key's worth past the period.
+	ctx->period = REPEAT_XOR_PERIOD / key_len * key_len;
+	size_t fill = ctx->period + key_len;
+	memcpy(ctx->pattern, key, key_len);
+	for (size_t have = key_len; have < fill; have *= 2) {
+		memcpy(ctx->pattern + have, ctx->pattern,
+		    have < fill - have ? have : fill - have);
+	}
+	return REPEAT_XOR_OK;
+}
+
+repeat_xor_status
+repeat_xor_update(repeat_xor_ctx *ctx, const uint8_t *in, uint8_t *out,
+    size_t len)
+{
+	STATS_SCOPE(STATS_REPEAT_XOR, len);
+
+	if (!ctx || !ctx->key || ((!in || !out) && len > 0)) {
+		return REPEAT_XOR_ERR_ARGS;
+	}
+
+	const uint8_t *source = ctx->period ? ctx->pattern : ctx->key;
+	size_t step = ctx->period ? ctx->period : ctx->key_len;
+	while (len > 0) {
+		size_t room = ctx->period ? step : step - ctx->offset;
+		size_t n = len < room ? len : room;
+		fixed_xor_buffers(in, source + ctx->offset, out, n);
+		ctx->offset = (ctx->offset + n) % ctx->key_len;
+		in += n;
+		out += n;
+		len -= n;
+	}
+	return REPEAT_XOR_OK;
+}
+
+repeat_xor_status
+repeating_key_xor(const uint8_t *in, uint8_t *out, size_t len,
+    const uint8_t *key, size_t key_len)
+{
+	repeat_xor_ctx ctx;
+	repeat_xor_status status = repeat_xor_init(&ctx, key, key_len);
+	if (status != REPEAT_XOR_OK) {
+		return status;
+	}
+	return repeat_xor_update(&ctx, in, out, len);
+}
+
+/**
+ * @brief Average bits per byte that differ between consecutive blocks of
+ * @p key_len bytes, over the first REPEAT_XOR_SAMPLE bytes.
+ */
+static double
+repeat_xor_normalized_distance(const uint8_t *cipher, size_t len,
+    size_t key_len)
+{
+	size_t span = len < REPEAT_XOR_SAMPLE ? len : REPEAT_XOR_SAMPLE;
+	size_t pairs = span / key_len - 1;
+
+	// Block i against block i + 1 is one contiguous comparison of the
+	// sample against itself shifted by a key length.
+	uint64_t bits = 0;
+	hamming_distance(cipher, cipher + key_len, pairs * key_len, &bits);
+	return (double) bits / (double) (pairs * key_len);
+}
+
+static int
+repeat_xor_compare_distance(const void *lhs, const void *rhs)
+{
+	const repeat_xor_candidate *a = lhs;
+	const repeat_xor_candidate *b = rhs;
+	if (a->distance != b->distance) {
+		return a->distance < b->distance ? -1 : 1;
+	}
+	return a->key_len < b->key_len ? -1 : a->key_len > b->key_len;
+}
+
+/**
+ * @brief One worker's share of the breaker.
+ *
+ * Units are (candidate, column) pairs numbered across candidates in order:
+ * candidate 0's columns first, then candidate 1's, and so on. Each worker
+ * first gathers partial column histograms for its slice of the ciphertext
+ * rows, then sums every worker's partials for its range of units and
+ * solves those columns.
+ */
+typedef struct
+{
+	const uint8_t *cipher;
+	size_t len;
+	repeat_xor_candidate *cands;
+	size_t ncands;
+	size_t units;
+	size_t index;		/**< This worker's number. */
+	size_t threads;		/**< Total workers. */
+	uint64_t *hists;	/**< threads * units * 256 partial counters. */
+	double *scores;		/**< Column score per unit. */
+	size_t begin;		/**< First unit solved by this worker. */
+	size_t end;		/**< One past the last unit solved. */
+	repeat_xor_status status;
+} repeat_xor_worker;
+
+/**
+ * @brief Start of worker @p index's slice, rounded down to a whole number
+ * of @p key_len rows; @p threads as the index gives the end of the input.
+ */
+static size_t
+repeat_xor_row_start(size_t len, size_t key_len, size_t index,
+    size_t threads)
+{
+	if (index >= threads) {
+		return len;
+	}
+	// The same split as the other scanners, without overflowing len *
+	// index on huge inputs.
+	size_t offset = len <= SIZE_MAX / threads ? len * index / threads :
+	    len / threads * index + len % threads * index / threads;
+	return offset - offset % key_len;
+}
+
+/** @brief Phase one: histogram this worker's rows for every candidate. */
+static void *
+repeat_xor_worker_gather(void *arg)
+{
+	repeat_xor_worker *w = arg;
+	uint64_t *hist = w->hists + w->index * w->units * 256;
+
+	for (size_t c = 0; c < w->ncands; ++c) {
+		size_t k = w->cands[c].key_len;
+		size_t start = repeat_xor_row_start(w->len, k, w->index,
+		    w->threads);
+		size_t stop = repeat_xor_row_start(w->len, k, w->index + 1,
+		    w->threads);
+		// Slices start on a row boundary, so column numbers line up.
+		utils_transpose_columns(w->cipher + start, stop - start, k,
+		    NULL, 0, hist);
+		hist += k * 256;
+	}
+	return NULL;
+}
+
+/** @brief Phase two: merge partial histograms and solve columns. */
+static void *
+repeat_xor_worker_solve(void *arg)
+{
+	repeat_xor_worker *w = arg;
+	size_t c = 0;
+	size_t first = 0;	// Unit number of candidate c's column 0.
+
+	for (size_t u = w->begin; u < w->end; ++u) {
+		while (u >= first + w->cands[c].key_len) {
+			first += w->cands[c].key_len;
+			c++;
+		}
+		uint64_t hist[256];
+		memcpy(hist, w->hists + u * 256, sizeof(hist));
+		for (size_t t = 1; t < w->threads; ++t) {
+			const uint64_t *part = w->hists + (t * w->units + u) *
+			    256;
+			for (int b = 0; b < 256; ++b) {
+				hist[b] += part[b];
+			}
+		}
+		if (brute_force_single_byte_xor_histogram(hist,
+			&w->cands[c].key[u - first], &w->scores[u]) !=
+		    UTILS_OK) {
+			w->status = REPEAT_XOR_ERR_SCORE_FAIL;
+			break;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief Run @p fn for every worker; worker 0 runs on the calling thread.
+ */
+static repeat_xor_status
+repeat_xor_run_workers(repeat_xor_worker *workers, pthread_t *tids,
+    size_t threads, void *(*fn)(void *))
+{
+	repeat_xor_status status = corpus_scan_run_workers(workers,
+	    sizeof(*workers), threads, tids, fn) == 0 ? REPEAT_XOR_OK :
+	    REPEAT_XOR_ERR_THREAD;
+	for (size_t t = 0; t < threads && status == REPEAT_XOR_OK; ++t) {
+		status = workers[t].status;
+	}
+	return status;
+}
+
+repeat_xor_status
+repeat_xor_break(const uint8_t *cipher, size_t len, size_t min_key,
+    size_t max_key, size_t threads, repeat_xor_candidate *top,
+    size_t top_cap, size_t *top_len)
+{
+	if (!cipher || !top || !top_len || top_cap == 0 || min_key == 0 ||
+	    min_key > max_key || max_key > REPEAT_XOR_MAX_KEY) {
+		return REPEAT_XOR_ERR_ARGS;
+	}
+
+	// Rank every size that fits twice.
+	repeat_xor_candidate sizes[REPEAT_XOR_MAX_KEY];
+	size_t nsizes = 0;
+	for (size_t k = min_key; k <= max_key && 2 * k <= len; ++k) {
+		memset(&sizes[nsizes], 0, sizeof(sizes[nsizes]));
+		sizes[nsizes].key_len = k;
+		sizes[nsizes].distance = repeat_xor_normalized_distance(cipher,
+		    len, k);
+		nsizes++;
+	}
+	if (nsizes == 0) {
+		return REPEAT_XOR_ERR_TOO_SHORT;
+	}
+	qsort(sizes, nsizes, sizeof(sizes[0]), repeat_xor_compare_distance);
+
+	size_t ncands = nsizes < top_cap ? nsizes : top_cap;
+	size_t units = 0;
+	for (size_t c = 0; c < ncands; ++c) {
+		units += sizes[c].key_len;
+	}
+
+	if (threads == 0) {
+		threads = xor_scan_default_threads();
+	}
+	if (threads > units) {
+		threads = units;
+	}
+	// units is at most the sum of 1..REPEAT_XOR_MAX_KEY, so one worker's
+	// histograms always fit the budget and the product cannot overflow.
+	size_t hist_bytes = units * 256 * sizeof(uint64_t);
+	if (threads > REPEAT_XOR_HIST_BUDGET / hist_bytes) {
+		threads = REPEAT_XOR_HIST_BUDGET / hist_bytes;
+	}
+
+	arena *scratch = arena_scratch();
+	if (!scratch) {
+		return REPEAT_XOR_ERR_OOM;
+	}
+	arena_mark mark = arena_save(scratch);
+	// Every score and counter is written before it is read.
+	double *scores = arena_alloc(scratch, units * sizeof(*scores),
+	    _Alignof(double));
+	uint64_t *hists = arena_alloc(scratch, threads * hist_bytes,
+	    ARENA_MAX_ALIGN);
+	repeat_xor_worker *workers = arena_calloc(scratch, threads,
+	    sizeof(*workers));
+	pthread_t *tids = arena_calloc(scratch, threads, sizeof(*tids));
+	if (!scores || !hists || !workers || !tids) {
+		arena_restore(scratch, mark);
+		return REPEAT_XOR_ERR_OOM;
+	}
+
+	for (size_t t = 0; t < threads; ++t) {
+		workers[t].cipher = cipher;
+		workers[t].len = len;
+		workers[t].cands = sizes;
+		workers[t].ncands = ncands;
+		workers[t].units = units;
+		workers[t].index = t;
+		workers[t].threads = threads;
+		workers[t].hists = hists;
+		workers[t].scores = scores;
+		workers[t].begin = units * t / threads;
+		workers[t].end = units * (t + 1) / threads;
+	}
+
+	repeat_xor_status status = repeat_xor_run_workers(workers, tids,
+	    threads, repeat_xor_worker_gather);
+	if (status == REPEAT_XOR_OK) {
+		status = repeat_xor_run_workers(workers, tids, threads,
+		    repeat_xor_worker_solve);
+	}
+
+	if (status == REPEAT_XOR_OK) {
+		size_t u = 0;
+		for (size_t c = 0; c < ncands; ++c) {
+			double sum = 0.0;
+			for (size_t col = 0; col < sizes[c].key_len; ++col) {
+				sum += scores[u++];
+			}
+			sizes[c].score = sum / (double) sizes[c].key_len;
+		}
+		memcpy(top, sizes, ncands * sizeof(sizes[0]));
+		*top_len = ncands;
+	}
+
+	arena_restore(scratch, mark);
+	return status;
+}
@@ -1,14 +1,14 @@
 /**
  * @file score_english_hex.c
- * @brief Implementation of English scoring for hex-encoded strings.
+ * @brief Implementation of English scoring for raw and hex-encoded text.
  */
 
-#include <ctype.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "score_english_hex.h"
+#include "stats.h"
 #include "utils.h"
 
 /**
@@ -60,65 +60,135 @@ score_english_hex_status_string(score_english_hex_status status)
 		return "odd number of hex digits";
 	case SCORE_ENGLISH_HEX_ERR_INVALID_HEX:
 		return "invalid hex digit";
+	case SCORE_ENGLISH_HEX_PRUNED:
+		return "pruned below threshold";
 	default:
 		return "unknown score_english_hex error";
 	}
 }
 
-score_english_hex_status
-score_english_hex(const char *hex, double *score_out)
+/**
+ * @brief Byte classes used by the scoring kernel.
+ *
+ * Classes 0-25 are the letters a-z (either case) and share their index with
+ * english_freq[]; the remaining classes follow.
+ */
+enum
 {
-	if (!hex || !score_out) {
-		return SCORE_ENGLISH_HEX_ERR_ARGS;
-	}
+	SCORE_CLASS_SPACE = 26,	  /**< ' ', counted like a letter. */
+	SCORE_CLASS_NEUTRAL = 27, /**< Allowed but not counted as a letter. */
+	SCORE_CLASS_PENALTY = 28, /**< Non-printable or non-ASCII byte. */
+	SCORE_CLASS_COUNT = 29
+};
 
-	size_t hex_len = strlen(hex);
-	if (hex_len == 0) {
-		return SCORE_ENGLISH_HEX_ERR_EMPTY;
-	}
-	if (hex_len & 1U) {
-		return SCORE_ENGLISH_HEX_ERR_ODD_LENGTH;
-	}
+#define SP SCORE_CLASS_SPACE
+#define NEU SCORE_CLASS_NEUTRAL
+#define PEN SCORE_CLASS_PENALTY
 
-	int counts[27] = { 0 };	// letter+space counts
-	size_t total_letters = 0;
-	size_t total_bytes = 0;
-	double penalty = 0.0;
+/**
+ * @brief Class of every byte value, fixed at compile time.
+ *
+ * Tab, newline, carriage return and all printable symbols are neutral;
+ * other control bytes and everything above 0x7e are penalized. The table
+ * replaces isalpha()/tolower(), so scoring no longer depends on the locale.
+ */
+static const uint8_t score_class[256] = {
+	/* 0x00 */ PEN, PEN, PEN, PEN, PEN, PEN, PEN, PEN,
+	    PEN, NEU, NEU, PEN, PEN, NEU, PEN, PEN,
+	/* 0x10 */ PEN, PEN, PEN, PEN, PEN, PEN, PEN, PEN,
+	    PEN, PEN, PEN, PEN, PEN, PEN, PEN, PEN,
+	/* 0x20 */ SP, NEU, NEU, NEU, NEU, NEU, NEU, NEU,
+	    NEU, NEU, NEU, NEU, NEU, NEU, NEU, NEU,
+	/* 0x30 */ NEU, NEU, NEU, NEU, NEU, NEU, NEU, NEU,
+	    NEU, NEU, NEU, NEU, NEU, NEU, NEU, NEU,
+	/* 0x40 */ NEU, 0, 1, 2, 3, 4, 5, 6,
+	    7, 8, 9, 10, 11, 12, 13, 14,
+	/* 0x50 */ 15, 16, 17, 18, 19, 20, 21, 22,
+	    23, 24, 25, NEU, NEU, NEU, NEU, NEU,
+	/* 0x60 */ NEU, 0, 1, 2, 3, 4, 5, 6,
+	    7, 8, 9, 10, 11, 12, 13, 14,
+	/* 0x70 */ 15, 16, 17, 18, 19, 20, 21, 22,
+	    23, 24, 25, NEU, NEU, NEU, NEU, PEN,
+	/* 0x80 */ PEN, PEN, PEN, PEN, PEN, PEN, PEN, PEN,
+	    PEN, PEN, PEN, PEN, PEN, PEN, PEN, PEN,
+	/* 0x90 */ PEN, PEN, PEN, PEN, PEN, PEN, PEN, PEN,
+	    PEN, PEN, PEN, PEN, PEN, PEN, PEN, PEN,
+	/* 0xa0 */ PEN, PEN, PEN, PEN, PEN, PEN, PEN, PEN,
+	    PEN, PEN, PEN, PEN, PEN, PEN, PEN, PEN,
+	/* 0xb0 */ PEN, PEN, PEN, PEN, PEN, PEN, PEN, PEN,
+	    PEN, PEN, PEN, PEN, PEN, PEN, PEN, PEN,
+	/* 0xc0 */ PEN, PEN, PEN, PEN, PEN, PEN, PEN, PEN,
+	    PEN, PEN, PEN, PEN, PEN, PEN, PEN, PEN,
+	/* 0xd0 */ PEN, PEN, PEN, PEN, PEN, PEN, PEN, PEN,
+	    PEN, PEN, PEN, PEN, PEN, PEN, PEN, PEN,
+	/* 0xe0 */ PEN, PEN, PEN, PEN, PEN, PEN, PEN, PEN,
+	    PEN, PEN, PEN, PEN, PEN, PEN, PEN, PEN,
+	/* 0xf0 */ PEN, PEN, PEN, PEN, PEN, PEN, PEN, PEN,
+	    PEN, PEN, PEN, PEN, PEN, PEN, PEN, PEN,
+};
 
-	// Decode hex on the fly; no need to allocate a separate buffer.
-	for (size_t i = 0; i < hex_len; i += 2) {
-		int hi = hex_digit_value(hex[i]);
-		int lo = hex_digit_value(hex[i + 1]);
-		if (hi < 0 || lo < 0) {
-			return SCORE_ENGLISH_HEX_ERR_INVALID_HEX;
-		}
+#undef SP
+#undef NEU
+#undef PEN
 
-		uint8_t c = (uint8_t) ((hi << 4) | lo);
-		total_bytes++;
-
-		if (isalpha(c)) {
-			c = (uint8_t) tolower(c);
-			counts[c - 'a']++;
-			total_letters++;
-		} else if (c == ' ') {
-			counts[26]++;
-			total_letters++;
-		} else if (c == '\n' || c == '\r' || c == '\t' ||
-		    c == ',' || c == '.' || c == '\'' || c == '"') {
-			// Neutral punctuation/whitespace: allowed but not counted as letters.
-		} else if (c < 32 || c > 126) {
-			// Non-printable or non-ASCII characters: penalize heavily but keep scoring.
-			penalty += 50.0;
-			continue;
-		} else {
-			// Other printable symbols like ! ? ; : etc. are allowed but not counted as letters.
-		}
+/**
+ * @brief Running per-class byte counts for one piece of text.
+ */
+typedef struct
+{
+	size_t counts[SCORE_CLASS_COUNT];
+} score_english_tally;
+
+/**
+ * @brief Branch-free counting kernel: one table load and increment per byte.
+ *
+ * Four interleaved count arrays keep runs of same-class bytes (letters in
+ * English, penalties in random data) from serialising on one counter.
+ */
+static void
+score_english_accumulate(score_english_tally *t, const uint8_t *bytes,
+    size_t len)
+{
+	size_t lanes[4][SCORE_CLASS_COUNT] = { { 0 } };
+
+	size_t i = 0;
+	for (; i + 4 <= len; i += 4) {
+		lanes[0][score_class[bytes[i]]]++;
+		lanes[1][score_class[bytes[i + 1]]]++;
+		lanes[2][score_class[bytes[i + 2]]]++;
+		lanes[3][score_class[bytes[i + 3]]]++;
+	}
+	for (; i < len; ++i) {
+		lanes[0][score_class[bytes[i]]]++;
 	}
 
-	if (total_bytes == 0) {
+	for (int c = 0; c < SCORE_CLASS_COUNT; ++c) {
+		t->counts[c] += lanes[0][c] + lanes[1][c] + lanes[2][c] +
+		    lanes[3][c];
+	}
+}
+
+/**
+ * @brief Turn the class counts into the final English score.
+ */
+static score_english_hex_status
+score_english_finish(const score_english_tally *t, double *score_out)
+{
+	size_t letters = 0;
+	for (int c = 0; c <= SCORE_CLASS_SPACE; ++c) {
+		letters += t->counts[c];
+	}
+	size_t bytes = letters + t->counts[SCORE_CLASS_NEUTRAL] +
+	    t->counts[SCORE_CLASS_PENALTY];
+	if (bytes == 0) {
 		return SCORE_ENGLISH_HEX_ERR_EMPTY;
 	}
-	if (total_letters == 0) {
+
+	// Each non-printable byte costs 50; the product is exact for any
+	// realistic byte count, so this matches summing the penalty per byte.
+	double penalty = 50.0 * (double) t->counts[SCORE_CLASS_PENALTY];
+
+	if (letters == 0) {
 		*score_out = -1000.0 - penalty;
 		return SCORE_ENGLISH_HEX_OK;
 	}
@@ -126,8 +196,8 @@ score_english_hex(const char *hex, double *score_out)
 	// Lower chi2 means closer to English; we will invert it into a score.
 	double chi2 = 0.0;
 	for (int i = 0; i < 27; i++) {
-		double expected = english_freq[i] * (double) total_letters;
-		double observed = (double) counts[i];
+		double expected = english_freq[i] * (double) letters;
+		double observed = (double) t->counts[i];
 		double diff = observed - expected;
 		// Add a tiny constant to avoid division by zero.
 		chi2 += (diff * diff) / (expected + 1e-9);
@@ -135,9 +205,137 @@ score_english_hex(const char *hex, double *score_out)
 
 	// Convert chi-squared to a score.
 	// Smaller chi2 -> higher score. Add bonus for high proportion of letters/spaces.
-	double letter_ratio = (double) total_letters / (double) total_bytes;
-	double score = -chi2 + letter_ratio * 50.0 - penalty;
-
-	*score_out = score;
+	double letter_ratio = (double) letters / (double) bytes;
+	*score_out = -chi2 + letter_ratio * 50.0 - penalty;
 	return SCORE_ENGLISH_HEX_OK;
 }
+
+score_english_hex_status
+score_english_bytes(const uint8_t *bytes, size_t len, double *score_out)
+{
+	STATS_SCOPE(STATS_SCORE_ENGLISH, len);
+
+	if ((!bytes && len > 0) || !score_out) {
+		return SCORE_ENGLISH_HEX_ERR_ARGS;
+	}
+
+	score_english_tally tally = { { 0 } };
+	score_english_accumulate(&tally, bytes, len);
+	return score_english_finish(&tally, score_out);
+}
+
+score_english_hex_status
+score_english_hex(const char *hex, double *score_out)
+{
+	if (!hex) {
+		return SCORE_ENGLISH_HEX_ERR_ARGS;
+	}
+	return score_english_hex_n(hex, strlen(hex), score_out);
+}
+
+score_english_hex_status
+score_english_hex_n(const char *hex, size_t hex_len, double *score_out)
+{
+	STATS_SCOPE(STATS_SCORE_ENGLISH, hex_len / 2);
+
+	if ((!hex && hex_len > 0) || !score_out) {
+		return SCORE_ENGLISH_HEX_ERR_ARGS;
+	}
+	if (hex_len == 0) {
+		return SCORE_ENGLISH_HEX_ERR_EMPTY;
+	}
+	if (hex_len & 1U) {
+		return SCORE_ENGLISH_HEX_ERR_ODD_LENGTH;
+	}
+
+	// Decode a window at a time with the vectorized hex decoder and feed
+	// the byte scorer; the text never needs a heap copy.
+	score_english_tally tally = { { 0 } };
+	uint8_t window[256];
+
+	for (size_t i = 0; i < hex_len; i += 2 * sizeof(window)) {
+		size_t chunk = hex_len - i;
+		if (chunk > 2 * sizeof(window)) {
+			chunk = 2 * sizeof(window);
+		}
+
+		size_t filled = 0;
+		if (hex_to_bytes_n(hex + i, chunk, window, sizeof(window),
+			&filled) != UTILS_OK) {
+			return SCORE_ENGLISH_HEX_ERR_INVALID_HEX;
+		}
+		score_english_accumulate(&tally, window, filled);
+	}
+
+	return score_english_finish(&tally, score_out);
+}
+
+score_english_hex_status
+score_english_histogram(const uint64_t hist[256], uint8_t xor_key,
+    double *score_out)
+{
+	if (!hist || !score_out) {
+		return SCORE_ENGLISH_HEX_ERR_ARGS;
+	}
+
+	// Plaintext byte (b ^ key) occurs exactly as often as cipher byte b.
+	score_english_tally tally = { { 0 } };
+	for (int b = 0; b < 256; ++b) {
+		tally.counts[score_class[b ^ xor_key]] += (size_t) hist[b];
+	}
+
+	return score_english_finish(&tally, score_out);
+}
+
+score_english_hex_status
+score_english_distinct(const uint8_t *values, const uint64_t *counts,
+    size_t n, uint8_t xor_key, double *score_out)
+{
+	if (((!values || !counts) && n > 0) || !score_out) {
+		return SCORE_ENGLISH_HEX_ERR_ARGS;
+	}
+
+	score_english_tally tally = { { 0 } };
+	for (size_t i = 0; i < n; ++i) {
+		tally.counts[score_class[values[i] ^ xor_key]] +=
+		    (size_t) counts[i];
+	}
+
+	return score_english_finish(&tally, score_out);
+}
+
+score_english_hex_status
+score_english_distinct_bounded(const uint8_t *values, const uint64_t *counts,
+    size_t n, uint8_t xor_key, double threshold, double *score_out,
+    size_t *examined_out)
+{
+	if (((!values || !counts) && n > 0) || !score_out) {
+		return SCORE_ENGLISH_HEX_ERR_ARGS;
+	}
+
+	// chi2 >= 0 and the letter ratio is at most 1, so the final score is
+	// at most 50 - 50 * penalties. Once more than this many penalized
+	// bytes have been seen the text cannot reach the threshold.
+	double limit = 1.0 - threshold / 50.0;
+
+	score_english_tally tally = { { 0 } };
+	for (size_t i = 0; i < n; ++i) {
+		uint8_t class = score_class[values[i] ^ xor_key];
+		tally.counts[class] += (size_t) counts[i];
+
+		size_t penalties = tally.counts[SCORE_CLASS_PENALTY];
+		if (class == SCORE_CLASS_PENALTY && i + 1 < n &&
+		    (double) penalties > limit) {
+			if (examined_out) {
+				*examined_out = i + 1;
+			}
+			*score_out = 50.0 - 50.0 * (double) penalties;
+			return SCORE_ENGLISH_HEX_PRUNED;
+		}
+	}
+
+	if (examined_out) {
+		*examined_out = n;
+	}
+	return score_english_finish(&tally, score_out);
+}
@@ -0,0 +1,206 @@
+/**
+ * @file stats.c
+ * @brief Implementation of the optional instrumentation counters.
+ *
+ * Each thread owns a block of counters that only it writes. Blocks sit on
+ * a global list so stats_snapshot() can read them, and a thread's block is
+ * folded into the retired totals when the thread exits.
+ */
+
+#include "stats.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *const stats_names[STATS_COUNT] = {
+	"hex_decode",
+	"hex_encode",
+	"base64_encode",
+	"base64_decode",
+	"fixed_xor",
+	"repeat_xor",
+	"score_english",
+	"key_rank",
+	"single_byte_xor",
+	"hamming",
+	"transpose",
+	"aes",
+};
+
+const char *
+stats_primitive_name(stats_primitive primitive)
+{
+	if ((unsigned) primitive >= STATS_COUNT) {
+		return "unknown";
+	}
+	return stats_names[primitive];
+}
+
+#ifdef CRYPTOPALS_STATS
+
+typedef struct stats_block
+{
+	stats_counter counters[STATS_COUNT];
+	struct stats_block *prev;
+	struct stats_block *next;
+} stats_block;
+
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t stats_once = PTHREAD_ONCE_INIT;
+static pthread_key_t stats_key;
+static int stats_key_ready;
+static stats_block *stats_live;
+static stats_counter stats_retired[STATS_COUNT];
+static _Thread_local stats_block *stats_mine;
+
+/** @brief Thread exit: fold the block into the retired totals. */
+static void
+stats_retire(void *p)
+{
+	stats_block *block = p;
+
+	pthread_mutex_lock(&stats_lock);
+	for (int i = 0; i < STATS_COUNT; ++i) {
+		stats_retired[i].calls += block->counters[i].calls;
+		stats_retired[i].bytes += block->counters[i].bytes;
+		stats_retired[i].ns += block->counters[i].ns;
+	}
+	if (block->prev) {
+		block->prev->next = block->next;
+	} else {
+		stats_live = block->next;
+	}
+	if (block->next) {
+		block->next->prev = block->prev;
+	}
+	pthread_mutex_unlock(&stats_lock);
+	free(block);
+}
+
+static void
+stats_init_key(void)
+{
+	stats_key_ready = pthread_key_create(&stats_key, stats_retire) == 0;
+}
+
+/** @brief The calling thread's block, registered on first use. */
+static stats_block *
+stats_local(void)
+{
+	if (stats_mine) {
+		return stats_mine;
+	}
+
+	pthread_once(&stats_once, stats_init_key);
+	stats_block *block = calloc(1, sizeof(*block));
+	if (!block) {
+		return NULL;
+	}
+	if (stats_key_ready) {
+		pthread_setspecific(stats_key, block);
+	}
+
+	pthread_mutex_lock(&stats_lock);
+	block->next = stats_live;
+	if (stats_live) {
+		stats_live->prev = block;
+	}
+	stats_live = block;
+	pthread_mutex_unlock(&stats_lock);
+
+	stats_mine = block;
+	return block;
+}
+
+void
+stats_record(stats_primitive primitive, uint64_t bytes, uint64_t ns)
+{
+	stats_block *block = stats_local();
+	if (!block || (unsigned) primitive >= STATS_COUNT) {
+		return;
+	}
+
+	// Only this thread writes the block; relaxed atomics keep a
+	// concurrent stats_snapshot() from reading torn values.
+	stats_counter *c = &block->counters[primitive];
+	__atomic_store_n(&c->calls, c->calls + 1, __ATOMIC_RELAXED);
+	__atomic_store_n(&c->bytes, c->bytes + bytes, __ATOMIC_RELAXED);
+	__atomic_store_n(&c->ns, c->ns + ns, __ATOMIC_RELAXED);
+}
+
+void
+stats_snapshot(stats_counter *out)
+{
+	pthread_mutex_lock(&stats_lock);
+	memcpy(out, stats_retired, sizeof(stats_retired));
+	for (stats_block *block = stats_live; block; block = block->next) {
+		for (int i = 0; i < STATS_COUNT; ++i) {
+			const stats_counter *c = &block->counters[i];
+			out[i].calls += __atomic_load_n(&c->calls,
+			    __ATOMIC_RELAXED);
+			out[i].bytes += __atomic_load_n(&c->bytes,
+			    __ATOMIC_RELAXED);
+			out[i].ns += __atomic_load_n(&c->ns, __ATOMIC_RELAXED);
+		}
+	}
+	pthread_mutex_unlock(&stats_lock);
+}
+
+void
+stats_dump(FILE *out)
+{
+	stats_counter totals[STATS_COUNT];
+	stats_snapshot(totals);
+
+	fprintf(out, "%-16s %12s %14s %12s %10s\n", "primitive", "calls",
+	    "bytes", "ms", "MB/s");
+	for (int i = 0; i < STATS_COUNT; ++i) {
+		if (totals[i].calls == 0) {
+			continue;
+		}
+		fprintf(out, "%-16s %12llu %14llu %12.3f", stats_names[i],
+		    (unsigned long long) totals[i].calls,
+		    (unsigned long long) totals[i].bytes,
+		    (double) totals[i].ns / 1e6);
+		if (totals[i].bytes > 0 && totals[i].ns > 0) {
+			fprintf(out, " %10.1f\n", (double) totals[i].bytes *
+			    1e3 / (double) totals[i].ns);
+		} else {
+			fprintf(out, " %10s\n", "-");
+		}
+	}
+}
+
+static void
+stats_dump_stderr(void)
+{
+	stats_dump(stderr);
+}
+
+void
+stats_dump_at_exit(void)
+{
+	atexit(stats_dump_stderr);
+}
+
+#else
+
+void
+stats_snapshot(stats_counter *out)
+{
+	memset(out, 0, STATS_COUNT * sizeof(*out));
+}
+
+void
+stats_dump(FILE *out)
+{
+	(void) out;
+}
+
+void
+stats_dump_at_exit(void)
+{
+}
+
+#endif /* CRYPTOPALS_STATS */
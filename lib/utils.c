@@ -6,12 +6,21 @@
 #include "utils.h"
 
 #include <ctype.h>
+#include <math.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
-#include "fixed_xor.h"
+#include "cpu_features.h"
 #include "score_english_hex.h"
+#include "stats.h"
+
+/** @brief Input bytes per block walked by utils_transpose_columns(). */
+#define UTILS_TRANSPOSE_BLOCK 16384
+
+#if CPU_FEATURES_X86
+#include <immintrin.h>
+#endif
 
 const char *
 utils_status_string(utils_status status)
@@ -51,11 +60,170 @@ hex_digit_value(int c)
 utils_status
 hex_to_bytes(const char *hex, uint8_t *out, size_t out_cap, size_t *out_len)
 {
-	if (!hex || (!out && out_cap > 0)) {
+	if (!hex) {
+		return UTILS_ERR_ARGS;
+	}
+	return hex_to_bytes_n(hex, strlen(hex), out, out_cap, out_len);
+}
+
+/**
+ * @brief Portable decoder: @p byte_len bytes from 2 * @p byte_len digits.
+ */
+static utils_status
+hex_decode_scalar(const char *hex, uint8_t *out, size_t byte_len)
+{
+	for (size_t i = 0; i < byte_len; ++i) {
+		int hi = hex_digit_value((unsigned char) hex[2 * i]);
+		int lo = hex_digit_value((unsigned char) hex[2 * i + 1]);
+		if (hi < 0 || lo < 0) {
+			return UTILS_ERR_INVALID_HEX;
+		}
+		out[i] = (uint8_t) ((hi << 4) | lo);
+	}
+	return UTILS_OK;
+}
+
+#if CPU_FEATURES_X86
+/*
+ * The vector decoders classify 16 or 32 characters at once with signed byte
+ * compares. Every valid digit is below 0x80, and bytes at or above 0x80
+ * compare as negative, so they fail both the digit and the letter range.
+ * Each pair of nibbles is then merged within a 16-bit lane:
+ * (even << 4) | odd.
+ */
+
+__attribute__((target("sse2")))
+static inline __m128i
+hex_nibbles_sse2(__m128i c, __m128i *valid)
+{
+	__m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+	__m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+	    _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+	__m128i alpha = _mm_and_si128(
+	    _mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+	    _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+	*valid = _mm_and_si128(*valid, _mm_or_si128(digit, alpha));
+
+	__m128i from_digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+	__m128i from_alpha = _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10));
+	return _mm_or_si128(_mm_and_si128(digit, from_digit),
+	    _mm_andnot_si128(digit, from_alpha));
+}
+
+__attribute__((target("sse2")))
+static inline __m128i
+hex_pairs_sse2(__m128i nibbles)
+{
+	__m128i hi = _mm_slli_epi16(_mm_and_si128(nibbles,
+		_mm_set1_epi16(0x00FF)), 4);
+	return _mm_or_si128(hi, _mm_srli_epi16(nibbles, 8));
+}
+
+/** @brief SSE2 decoder: 32 hex characters per iteration. */
+__attribute__((target("sse2")))
+static utils_status
+hex_decode_sse2(const char *hex, uint8_t *out, size_t byte_len)
+{
+	size_t i = 0;
+	for (; i + 16 <= byte_len; i += 16) {
+		__m128i valid = _mm_set1_epi8(-1);
+		__m128i a = hex_nibbles_sse2(_mm_loadu_si128(
+			(const __m128i *) (hex + 2 * i)), &valid);
+		__m128i b = hex_nibbles_sse2(_mm_loadu_si128(
+			(const __m128i *) (hex + 2 * i + 16)), &valid);
+		if (_mm_movemask_epi8(valid) != 0xFFFF) {
+			return UTILS_ERR_INVALID_HEX;
+		}
+		_mm_storeu_si128((__m128i *) (out + i),
+		    _mm_packus_epi16(hex_pairs_sse2(a), hex_pairs_sse2(b)));
+	}
+	return hex_decode_scalar(hex + 2 * i, out + i, byte_len - i);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i
+hex_nibbles_avx2(__m256i c, __m256i *valid)
+{
+	__m256i lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+	__m256i digit = _mm256_andnot_si256(
+	    _mm256_cmpgt_epi8(c, _mm256_set1_epi8('9')),
+	    _mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)));
+	__m256i alpha = _mm256_andnot_si256(
+	    _mm256_cmpgt_epi8(lower, _mm256_set1_epi8('f')),
+	    _mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)));
+	*valid = _mm256_and_si256(*valid, _mm256_or_si256(digit, alpha));
+
+	__m256i from_digit = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+	__m256i from_alpha = _mm256_sub_epi8(lower,
+	    _mm256_set1_epi8('a' - 10));
+	return _mm256_blendv_epi8(from_alpha, from_digit, digit);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i
+hex_pairs_avx2(__m256i nibbles)
+{
+	__m256i hi = _mm256_slli_epi16(_mm256_and_si256(nibbles,
+		_mm256_set1_epi16(0x00FF)), 4);
+	return _mm256_or_si256(hi, _mm256_srli_epi16(nibbles, 8));
+}
+
+/** @brief AVX2 decoder: 64 hex characters per iteration. */
+__attribute__((target("avx2")))
+static utils_status
+hex_decode_avx2(const char *hex, uint8_t *out, size_t byte_len)
+{
+	size_t i = 0;
+	for (; i + 32 <= byte_len; i += 32) {
+		__m256i valid = _mm256_set1_epi8(-1);
+		__m256i a = hex_nibbles_avx2(_mm256_loadu_si256(
+			(const __m256i *) (hex + 2 * i)), &valid);
+		__m256i b = hex_nibbles_avx2(_mm256_loadu_si256(
+			(const __m256i *) (hex + 2 * i + 32)), &valid);
+		if (_mm256_movemask_epi8(valid) != -1) {
+			return UTILS_ERR_INVALID_HEX;
+		}
+		// packus interleaves 128-bit lanes; restore byte order.
+		__m256i packed = _mm256_packus_epi16(hex_pairs_avx2(a),
+		    hex_pairs_avx2(b));
+		_mm256_storeu_si256((__m256i *) (out + i),
+		    _mm256_permute4x64_epi64(packed, 0xD8));
+	}
+	return hex_decode_sse2(hex + 2 * i, out + i, byte_len - i);
+}
+#endif
+
+/**
+ * @brief Decode with the widest kernel the CPU supports.
+ *
+ * Every kernel reports UTILS_ERR_INVALID_HEX for the same inputs; only the
+ * bytes already written before the error may differ.
+ */
+static utils_status
+hex_decode(const char *hex, uint8_t *out, size_t byte_len)
+{
+#if CPU_FEATURES_X86
+	unsigned features = cpu_features();
+	if (features & CPU_FEATURE_AVX2) {
+		return hex_decode_avx2(hex, out, byte_len);
+	}
+	if (features & CPU_FEATURE_SSE2) {
+		return hex_decode_sse2(hex, out, byte_len);
+	}
+#endif
+	return hex_decode_scalar(hex, out, byte_len);
+}
+
+utils_status
+hex_to_bytes_n(const char *hex, size_t hex_len,
+    uint8_t *out, size_t out_cap, size_t *out_len)
+{
+	STATS_SCOPE(STATS_HEX_DECODE, hex_len);
+
+	if ((!hex && hex_len > 0) || (!out && out_cap > 0)) {
 		return UTILS_ERR_ARGS;
 	}
 
-	size_t hex_len = strlen(hex);
 	if (hex_len == 0) {
 		if (out_len) {
 			*out_len = 0;
@@ -72,13 +240,9 @@ hex_to_bytes(const char *hex, uint8_t *out, size_t out_cap, size_t *out_len)
 		return UTILS_ERR_BUFFER_TOO_SMALL;
 	}
 
-	for (size_t i = 0; i < byte_len; ++i) {
-		int hi = hex_digit_value((unsigned char) hex[2 * i]);
-		int lo = hex_digit_value((unsigned char) hex[2 * i + 1]);
-		if (hi < 0 || lo < 0) {
-			return UTILS_ERR_INVALID_HEX;
-		}
-		out[i] = (uint8_t) ((hi << 4) | lo);
+	utils_status status = hex_decode(hex, out, byte_len);
+	if (status != UTILS_OK) {
+		return status;
 	}
 
 	if (out_len) {
@@ -87,9 +251,79 @@ hex_to_bytes(const char *hex, uint8_t *out, size_t out_cap, size_t *out_len)
 	return UTILS_OK;
 }
 
+static const char hex_digits[] = "0123456789abcdef";
+
+static void
+hex_encode_scalar(const uint8_t *bytes, size_t len, char *out_hex)
+{
+	for (size_t i = 0; i < len; ++i) {
+		out_hex[2 * i] = hex_digits[(bytes[i] >> 4) & 0xF];
+		out_hex[2 * i + 1] = hex_digits[bytes[i] & 0xF];
+	}
+}
+
+#if CPU_FEATURES_X86
+/*
+ * The vector encoders split each byte into nibbles and map both through a
+ * 16-entry pshufb lookup of hex_digits, then interleave the high and low
+ * digit vectors back into character order.
+ */
+
+/** @brief SSSE3 encoder: 16 bytes (32 characters) per iteration. */
+__attribute__((target("ssse3")))
+static void
+hex_encode_ssse3(const uint8_t *bytes, size_t len, char *out_hex)
+{
+	const __m128i table = _mm_loadu_si128((const __m128i *) hex_digits);
+	const __m128i mask = _mm_set1_epi8(0x0F);
+
+	size_t i = 0;
+	for (; i + 16 <= len; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *) (bytes + i));
+		__m128i hi = _mm_shuffle_epi8(table,
+		    _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+		__m128i lo = _mm_shuffle_epi8(table, _mm_and_si128(v, mask));
+		_mm_storeu_si128((__m128i *) (out_hex + 2 * i),
+		    _mm_unpacklo_epi8(hi, lo));
+		_mm_storeu_si128((__m128i *) (out_hex + 2 * i + 16),
+		    _mm_unpackhi_epi8(hi, lo));
+	}
+	hex_encode_scalar(bytes + i, len - i, out_hex + 2 * i);
+}
+
+/** @brief AVX2 encoder: 32 bytes (64 characters) per iteration. */
+__attribute__((target("avx2")))
+static void
+hex_encode_avx2(const uint8_t *bytes, size_t len, char *out_hex)
+{
+	const __m256i table = _mm256_broadcastsi128_si256(
+	    _mm_loadu_si128((const __m128i *) hex_digits));
+	const __m256i mask = _mm256_set1_epi8(0x0F);
+
+	size_t i = 0;
+	for (; i + 32 <= len; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *) (bytes + i));
+		__m256i hi = _mm256_shuffle_epi8(table,
+		    _mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+		__m256i lo = _mm256_shuffle_epi8(table,
+		    _mm256_and_si256(v, mask));
+		// unpack works per 128-bit lane; reassemble lane order.
+		__m256i first = _mm256_unpacklo_epi8(hi, lo);
+		__m256i second = _mm256_unpackhi_epi8(hi, lo);
+		_mm256_storeu_si256((__m256i *) (out_hex + 2 * i),
+		    _mm256_permute2x128_si256(first, second, 0x20));
+		_mm256_storeu_si256((__m256i *) (out_hex + 2 * i + 32),
+		    _mm256_permute2x128_si256(first, second, 0x31));
+	}
+	hex_encode_ssse3(bytes + i, len - i, out_hex + 2 * i);
+}
+#endif
+
 utils_status
 bytes_to_hex(const uint8_t *bytes, size_t len, char *out_hex, size_t out_cap)
 {
+	STATS_SCOPE(STATS_HEX_ENCODE, len);
+
 	if (!bytes || !out_hex) {
 		return UTILS_ERR_ARGS;
 	}
@@ -98,11 +332,18 @@ bytes_to_hex(const uint8_t *bytes, size_t len, char *out_hex, size_t out_cap)
 		return UTILS_ERR_BUFFER_TOO_SMALL;
 	}
 
-	static const char digits[] = "0123456789abcdef";
-	for (size_t i = 0; i < len; ++i) {
-		out_hex[2 * i] = digits[(bytes[i] >> 4) & 0xF];
-		out_hex[2 * i + 1] = digits[bytes[i] & 0xF];
+#if CPU_FEATURES_X86
+	unsigned features = cpu_features();
+	if (features & CPU_FEATURE_AVX2) {
+		hex_encode_avx2(bytes, len, out_hex);
+	} else if (features & CPU_FEATURE_SSSE3) {
+		hex_encode_ssse3(bytes, len, out_hex);
+	} else {
+		hex_encode_scalar(bytes, len, out_hex);
 	}
+#else
+	hex_encode_scalar(bytes, len, out_hex);
+#endif
 	out_hex[2 * len] = '\0';
 	return UTILS_OK;
 }
@@ -110,40 +351,136 @@ bytes_to_hex(const uint8_t *bytes, size_t len, char *out_hex, size_t out_cap)
 utils_status
 hex_to_ascii(const char *hex, char *ascii_out, size_t ascii_cap)
 {
-	if (!hex || !ascii_out) {
+	if (!hex) {
 		return UTILS_ERR_ARGS;
 	}
+	return hex_to_ascii_n(hex, strlen(hex), ascii_out, ascii_cap);
+}
 
-	size_t hex_len = strlen(hex);
-	size_t ascii_len = hex_len / 2;
+utils_status
+hex_to_ascii_n(const char *hex, size_t hex_len, char *ascii_out,
+    size_t ascii_cap)
+{
+	if ((!hex && hex_len > 0) || !ascii_out) {
+		return UTILS_ERR_ARGS;
+	}
 
+	size_t ascii_len = hex_len / 2;
 	if (ascii_len + 1 > ascii_cap) {
 		return UTILS_ERR_BUFFER_TOO_SMALL;
 	}
 
-	for (size_t i = 0; i < ascii_len; ++i) {
-		int hi = hex_digit_value((unsigned char) hex[2 * i]);
-		int lo = hex_digit_value((unsigned char) hex[2 * i + 1]);
-		if (hi < 0 || lo < 0) {
-			return UTILS_ERR_INVALID_HEX;
-		}
-		ascii_out[i] = (char) ((hi << 4) | lo);
+	// A trailing odd digit is ignored, as it always has been; the whole
+	// pairs go through the vector decoder.
+	utils_status status = hex_to_bytes_n(hex, 2 * ascii_len,
+	    (uint8_t *) ascii_out, ascii_len, NULL);
+	if (status != UTILS_OK) {
+		return status;
 	}
 
 	ascii_out[ascii_len] = '\0';
 	return UTILS_OK;
 }
 
+utils_status
+utils_byte_histogram(const uint8_t *bytes, size_t len, uint64_t hist[256])
+{
+	if ((!bytes && len > 0) || !hist) {
+		return UTILS_ERR_ARGS;
+	}
+
+	// Four interleaved tables keep runs of equal bytes from serialising
+	// on a single counter.
+	uint64_t lanes[4][256];
+	memset(lanes, 0, sizeof(lanes));
+
+	size_t i = 0;
+	for (; i + 4 <= len; i += 4) {
+		lanes[0][bytes[i]]++;
+		lanes[1][bytes[i + 1]]++;
+		lanes[2][bytes[i + 2]]++;
+		lanes[3][bytes[i + 3]]++;
+	}
+	for (; i < len; ++i) {
+		lanes[0][bytes[i]]++;
+	}
+
+	for (int b = 0; b < 256; ++b) {
+		hist[b] = lanes[0][b] + lanes[1][b] + lanes[2][b] + lanes[3][b];
+	}
+	return UTILS_OK;
+}
+
+utils_status
+brute_force_single_byte_xor_histogram(const uint64_t hist[256],
+    uint8_t *out_key, double *out_score)
+{
+	STATS_SCOPE(STATS_KEY_RANK, 0);
+
+	if (!hist || !out_key) {
+		return UTILS_ERR_ARGS;
+	}
+
+	// Only the byte values that occur affect the score; short texts have
+	// few of them, so compact once instead of walking 256 bins per key.
+	uint8_t values[256];
+	uint64_t counts[256];
+	size_t distinct = 0;
+	for (int b = 0; b < 256; ++b) {
+		if (hist[b] != 0) {
+			values[distinct] = (uint8_t) b;
+			counts[distinct++] = hist[b];
+		}
+	}
+
+	double best_score = -1e12;
+	uint8_t best_key = 0;
+	double score = 0.0;
+
+	for (int key = 0; key <= 0xFF; ++key) {
+		score_english_hex_status score_status =
+		    score_english_distinct(values, counts, distinct,
+		    (uint8_t) key, &score);
+		if (score_status != SCORE_ENGLISH_HEX_OK) {
+			return UTILS_ERR_SCORE_FAIL;
+		}
+
+		if (score > best_score) {
+			best_score = score;
+			best_key = (uint8_t) key;
+		}
+	}
+
+	*out_key = best_key;
+	if (out_score) {
+		*out_score = best_score;
+	}
+	return UTILS_OK;
+}
+
 utils_status
 brute_force_single_byte_xor(const char *hex_input,
     uint8_t *out_plain,
     size_t out_cap, size_t *out_len, uint8_t *out_key, double *out_score)
 {
+	if (!hex_input) {
+		return UTILS_ERR_ARGS;
+	}
+	return brute_force_single_byte_xor_n(hex_input, strlen(hex_input),
+	    out_plain, out_cap, out_len, out_key, out_score);
+}
+
+utils_status
+brute_force_single_byte_xor_n(const char *hex_input, size_t hex_len,
+    uint8_t *out_plain,
+    size_t out_cap, size_t *out_len, uint8_t *out_key, double *out_score)
+{
+	STATS_SCOPE(STATS_SINGLE_BYTE_XOR, hex_len / 2);
+
 	if (!hex_input || !out_plain || !out_len || !out_key) {
 		return UTILS_ERR_ARGS;
 	}
 
-	size_t hex_len = strlen(hex_input);
 	if (hex_len == 0) {
 		return UTILS_ERR_ARGS;
 	}
@@ -156,90 +493,184 @@ brute_force_single_byte_xor(const char *hex_input,
 		return UTILS_ERR_BUFFER_TOO_SMALL;
 	}
 
-	uint8_t *cipher = malloc(byte_len);
-	uint8_t *candidate = malloc(byte_len);
-	uint8_t *key_stream = malloc(byte_len);
-	char *candidate_hex = malloc(2 * byte_len + 1);
-	if (!cipher || !candidate || !key_stream || !candidate_hex) {
-		free(cipher);
-		free(candidate);
-		free(key_stream);
-		free(candidate_hex);
-		return UTILS_ERR_OOM;
-	}
-
+	// Decode straight into the caller's buffer, score every key from a
+	// single histogram, then apply the winning key in place.
 	utils_status decode_status =
-	    hex_to_bytes(hex_input, cipher, byte_len, NULL);
+	    hex_to_bytes_n(hex_input, hex_len, out_plain, byte_len, NULL);
 	if (decode_status != UTILS_OK) {
-		free(cipher);
-		free(candidate);
-		free(key_stream);
-		free(candidate_hex);
 		return decode_status;
 	}
 
-	double best_score = -1e12;
+	uint64_t hist[256];
+	utils_status status = utils_byte_histogram(out_plain, byte_len, hist);
+	if (status != UTILS_OK) {
+		return status;
+	}
+
 	uint8_t best_key = 0;
-	double score = 0.0;
+	double best_score = 0.0;
+	status = brute_force_single_byte_xor_histogram(hist, &best_key,
+	    &best_score);
+	if (status != UTILS_OK) {
+		return status;
+	}
 
-	for (int key = 0; key <= 0xFF; ++key) {
-		memset(key_stream, (uint8_t) key, byte_len);
+	for (size_t i = 0; i < byte_len; ++i) {
+		out_plain[i] ^= best_key;
+	}
 
-		fixed_xor_status status =
-		    fixed_xor_buffers(cipher, key_stream, candidate, byte_len);
-		if (status != FIXED_XOR_OK) {
-			continue;
+	*out_len = byte_len;
+	*out_key = best_key;
+	if (out_score) {
+		*out_score = best_score;
+	}
+	return UTILS_OK;
+}
+
+utils_status
+brute_force_single_byte_xor_batch(const utils_hex_view *inputs,
+    size_t count, uint8_t *arena, size_t arena_cap, utils_xor_result *results)
+{
+	if ((!inputs || !results) && count > 0) {
+		return UTILS_ERR_ARGS;
+	}
+
+	// Lay the plaintexts out first so an undersized arena fails before
+	// any result is written.
+	size_t need = 0;
+	for (size_t i = 0; i < count; ++i) {
+		if (!inputs[i].hex && inputs[i].len > 0) {
+			return UTILS_ERR_ARGS;
+		}
+		need += inputs[i].len / 2;
+	}
+	if (need > arena_cap || (!arena && need > 0)) {
+		return UTILS_ERR_BUFFER_TOO_SMALL;
+	}
+
+	size_t offset = 0;
+	for (size_t i = 0; i < count; ++i) {
+		utils_xor_result *r = &results[i];
+		size_t len = 0;
+
+		r->key = 0;
+		r->score = 0.0;
+		r->plain_offset = offset;
+		r->plain_len = 0;
+		r->status = inputs[i].len == 0 ? UTILS_ERR_ARGS :
+		    brute_force_single_byte_xor_n(inputs[i].hex, inputs[i].len,
+		    arena + offset, inputs[i].len / 2, &len, &r->key,
+		    &r->score);
+		if (r->status == UTILS_OK) {
+			r->plain_len = len;
 		}
+		offset += inputs[i].len / 2;
+	}
+	return UTILS_OK;
+}
 
-		utils_status hex_status =
-		    bytes_to_hex(candidate, byte_len, candidate_hex,
-		    2 * byte_len + 1);
-		if (hex_status != UTILS_OK) {
-			free(cipher);
-			free(candidate);
-			free(key_stream);
-			free(candidate_hex);
-			return hex_status;
+/**
+ * @brief Whether @p a ranks ahead of @p b: higher score, then lower key.
+ */
+static int
+key_score_before(const utils_key_score *a, const utils_key_score *b)
+{
+	return a->score > b->score ||
+	    (a->score == b->score && a->key < b->key);
+}
+
+utils_status
+brute_force_single_byte_xor_top_k(const uint64_t hist[256], size_t k,
+    utils_key_score *out, size_t *out_count, size_t *out_examined)
+{
+	STATS_SCOPE(STATS_KEY_RANK, 0);
+
+	if (!hist || k == 0 || !out || !out_count) {
+		return UTILS_ERR_ARGS;
+	}
+	if (k > 256) {
+		k = 256;
+	}
+
+	// Compact the histogram commonest value first, so the entries a key
+	// is judged on first cover as much of the text as possible.
+	uint8_t values[256];
+	uint64_t counts[256];
+	size_t distinct = 0;
+	for (int b = 0; b < 256; ++b) {
+		if (hist[b] == 0) {
+			continue;
 		}
+		size_t pos = distinct++;
+		while (pos > 0 && counts[pos - 1] < hist[b]) {
+			values[pos] = values[pos - 1];
+			counts[pos] = counts[pos - 1];
+			--pos;
+		}
+		values[pos] = (uint8_t) b;
+		counts[pos] = hist[b];
+	}
+	if (distinct == 0) {
+		return UTILS_ERR_ARGS;
+	}
+
+	// The commonest byte is most likely a space. Keys that differ from
+	// its key only in the low bits keep most letters letters, so walking
+	// outwards from it fills the top k with good scores early.
+	uint8_t seed = values[0] ^ (uint8_t) ' ';
+
+	size_t filled = 0;
+	size_t examined_total = 0;
+	for (int j = 0; j <= 0xFF; ++j) {
+		utils_key_score cand = { (uint8_t) (seed ^ j), 0.0 };
+		double threshold = filled < k ? -HUGE_VAL : out[k - 1].score;
+		size_t examined = 0;
 
 		score_english_hex_status score_status =
-		    score_english_hex(candidate_hex, &score);
+		    score_english_distinct_bounded(values, counts, distinct,
+		    cand.key, threshold, &cand.score, &examined);
+		examined_total += examined;
+		if (score_status == SCORE_ENGLISH_HEX_PRUNED) {
+			continue;
+		}
 		if (score_status != SCORE_ENGLISH_HEX_OK) {
-			free(cipher);
-			free(candidate);
-			free(key_stream);
-			free(candidate_hex);
 			return UTILS_ERR_SCORE_FAIL;
 		}
+		if (filled == k && !key_score_before(&cand, &out[k - 1])) {
+			continue;
+		}
 
-		if (score > best_score) {
-			best_score = score;
-			best_key = (uint8_t) key;
-			memcpy(out_plain, candidate, byte_len);
+		size_t pos = filled < k ? filled++ : k - 1;
+		while (pos > 0 && key_score_before(&cand, &out[pos - 1])) {
+			out[pos] = out[pos - 1];
+			--pos;
 		}
+		out[pos] = cand;
 	}
 
-	*out_len = byte_len;
-	*out_key = best_key;
-	if (out_score) {
-		*out_score = best_score;
+	*out_count = filled;
+	if (out_examined) {
+		*out_examined = examined_total;
 	}
-
-	free(cipher);
-	free(candidate);
-	free(key_stream);
-	free(candidate_hex);
 	return UTILS_OK;
 }
 
 utils_status
 utils_repeat_key(const char *key, uint8_t *out, size_t buffer_len)
 {
-	if (!key || (!out && buffer_len > 0)) {
+	if (!key) {
 		return UTILS_ERR_ARGS;
 	}
+	return utils_repeat_key_n(key, strlen(key), out, buffer_len);
+}
 
-	size_t key_len = strlen(key);
+utils_status
+utils_repeat_key_n(const char *key, size_t key_len, uint8_t *out,
+    size_t buffer_len)
+{
+	if (!key || (!out && buffer_len > 0)) {
+		return UTILS_ERR_ARGS;
+	}
 	if (key_len == 0 && buffer_len > 0) {
 		return UTILS_ERR_ARGS;
 	}
@@ -249,3 +680,65 @@ utils_repeat_key(const char *key, uint8_t *out, size_t buffer_len)
 	}
 	return UTILS_OK;
 }
+
+utils_status
+utils_transpose_columns(const uint8_t *in, size_t len, size_t columns,
+    uint8_t *out, size_t out_cap, uint64_t *hist)
+{
+	STATS_SCOPE(STATS_TRANSPOSE, len);
+
+	if ((!in && len > 0) || columns == 0 || (!out && out_cap > 0)) {
+		return UTILS_ERR_ARGS;
+	}
+	if (out && out_cap < len) {
+		return UTILS_ERR_BUFFER_TOO_SMALL;
+	}
+	if (hist) {
+		memset(hist, 0, columns * 256 * sizeof(*hist));
+	}
+
+	size_t rows = len / columns;
+	size_t extra = len % columns;
+	size_t total_rows = rows + (extra > 0);
+	size_t block_rows = UTILS_TRANSPOSE_BLOCK / columns;
+	if (block_rows == 0) {
+		block_rows = 1;
+	}
+
+	for (size_t row0 = 0; row0 < total_rows; row0 += block_rows) {
+		size_t row_end = row0 + block_rows < total_rows ?
+		    row0 + block_rows : total_rows;
+		for (size_t c = 0; c < columns; ++c) {
+			// The last, partial row only has the first extra columns.
+			size_t end = c >= extra && row_end > rows ? rows : row_end;
+			if (end <= row0) {
+				continue;
+			}
+			size_t n = end - row0;
+			const uint8_t *src = in + row0 * columns + c;
+
+			if (out && hist) {
+				uint8_t *dst = out + c * rows +
+				    (c < extra ? c : extra) + row0;
+				uint64_t *h = hist + c * 256;
+				for (size_t r = 0; r < n; ++r) {
+					uint8_t b = src[r * columns];
+					dst[r] = b;
+					h[b]++;
+				}
+			} else if (out) {
+				uint8_t *dst = out + c * rows +
+				    (c < extra ? c : extra) + row0;
+				for (size_t r = 0; r < n; ++r) {
+					dst[r] = src[r * columns];
+				}
+			} else if (hist) {
+				uint64_t *h = hist + c * 256;
+				for (size_t r = 0; r < n; ++r) {
+					h[src[r * columns]]++;
+				}
+			}
+		}
+	}
+	return UTILS_OK;
+}
@@ -0,0 +1,263 @@
+/**
+ * @file xor_scan.c
+ * @brief Implementation of the multithreaded single-byte XOR line scanner.
+ */
+
+#include "xor_scan.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "arena.h"
+#include "corpus_scan.h"
+#include "hex_corpus.h"
+#include "utils.h"
+
+/**
+ * @brief Per-worker state: its shard of lines and its private heap.
+ *
+ * A shard is either a range of a line array or a byte range of a corpus;
+ * @c lines is NULL in the latter case.
+ */
+typedef struct
+{
+	const char *const *lines;
+	size_t begin;
+	size_t end;
+	hex_corpus_cursor cursor;
+	corpus_scan_heap heap;
+	size_t skipped;
+	xor_scan_status status;
+} xor_scan_worker;
+
+const char *
+xor_scan_status_string(xor_scan_status status)
+{
+	switch (status) {
+	case XOR_SCAN_OK:
+		return "success";
+	case XOR_SCAN_ERR_ARGS:
+		return "invalid arguments";
+	case XOR_SCAN_ERR_OOM:
+		return "out of memory";
+	case XOR_SCAN_ERR_THREAD:
+		return "failed to start worker thread";
+	default:
+		return "unknown xor_scan error";
+	}
+}
+
+size_t
+xor_scan_default_threads(void)
+{
+	long online = sysconf(_SC_NPROCESSORS_ONLN);
+	return online > 0 ? (size_t) online : 1;
+}
+
+/** @brief Return non-zero when @p a ranks below @p b. */
+static int
+xor_scan_worse(const void *lhs, const void *rhs)
+{
+	const xor_scan_result *a = lhs;
+	const xor_scan_result *b = rhs;
+
+	if (a->score != b->score) {
+		return a->score < b->score;
+	}
+	if (a->line != b->line) {
+		return a->line > b->line;
+	}
+	// Corpus lines are numbered after the merge; until then their
+	// position in the mapping orders them the same way.
+	return a->hex > b->hex;
+}
+
+/**
+ * @brief Fetch the next line of the worker's shard.
+ *
+ * @return 1 when @p view was filled, 0 when the shard is exhausted.
+ */
+static int
+xor_scan_worker_next(xor_scan_worker *worker, hex_corpus_line *view,
+    size_t *line)
+{
+	if (!worker->lines) {
+		*line = SIZE_MAX;
+		return hex_corpus_next(&worker->cursor, view);
+	}
+	if (worker->begin >= worker->end) {
+		return 0;
+	}
+
+	*line = worker->begin++;
+	view->data = worker->lines[*line];
+	view->len = view->data ? strlen(view->data) : 0;
+	return 1;
+}
+
+static void *
+xor_scan_worker_run(void *arg)
+{
+	xor_scan_worker *worker = arg;
+	arena *scratch = arena_scratch();
+	if (!scratch) {
+		worker->status = XOR_SCAN_ERR_OOM;
+		return NULL;
+	}
+	arena_mark mark = arena_save(scratch);
+	uint8_t *plain = NULL;
+	size_t plain_cap = 0;
+	hex_corpus_line view;
+	size_t line;
+
+	while (xor_scan_worker_next(worker, &view, &line)) {
+		size_t need = view.len / 2;
+		if (need == 0) {
+			worker->skipped++;
+			continue;
+		}
+
+		// Grows to the longest line seen, never with the corpus size.
+		// Doubling bounds what the abandoned buffers waste.
+		if (need > plain_cap) {
+			size_t cap = 2 * plain_cap > need ? 2 * plain_cap : need;
+			plain = arena_alloc(scratch, cap, 1);
+			if (!plain) {
+				worker->status = XOR_SCAN_ERR_OOM;
+				break;
+			}
+			plain_cap = cap;
+		}
+
+		xor_scan_result result = { line, view.data, view.len, 0, 0.0 };
+		size_t plain_len = 0;
+		utils_status ustatus = brute_force_single_byte_xor_n(view.data,
+		    view.len, plain, plain_cap, &plain_len, &result.key,
+		    &result.score);
+		if (ustatus != UTILS_OK) {
+			worker->skipped++;
+			continue;
+		}
+
+		corpus_scan_heap_push(&worker->heap, &result);
+	}
+
+	arena_restore(scratch, mark);
+	return NULL;
+}
+
+/**
+ * @brief Run the workers, merge their heaps and emit the sorted top-N.
+ */
+static xor_scan_status
+xor_scan_run(const char *const *lines, size_t count,
+    const hex_corpus *corpus, size_t threads, xor_scan_result *top,
+    size_t top_cap, size_t *top_len, size_t *skipped)
+{
+	if (threads == 0) {
+		threads = xor_scan_default_threads();
+	}
+	if (lines && threads > count) {
+		threads = count > 0 ? count : 1;
+	}
+
+	arena *scratch = arena_scratch();
+	if (!scratch) {
+		return XOR_SCAN_ERR_OOM;
+	}
+	arena_mark mark = arena_save(scratch);
+	xor_scan_worker *workers = arena_calloc(scratch, threads,
+	    sizeof(*workers));
+	pthread_t *tids = arena_calloc(scratch, threads, sizeof(*tids));
+	if (!workers || !tids) {
+		arena_restore(scratch, mark);
+		return XOR_SCAN_ERR_OOM;
+	}
+
+	xor_scan_status status = XOR_SCAN_OK;
+	for (size_t t = 0; t < threads; ++t) {
+		if (lines) {
+			workers[t].lines = lines;
+			workers[t].begin = count * t / threads;
+			workers[t].end = count * (t + 1) / threads;
+		} else {
+			hex_corpus_shard(corpus, t, threads,
+			    &workers[t].cursor);
+		}
+		xor_scan_result *items = arena_calloc(scratch, top_cap,
+		    sizeof(xor_scan_result));
+		if (!items) {
+			status = XOR_SCAN_ERR_OOM;
+		}
+		corpus_scan_heap_init(&workers[t].heap, items, top_cap,
+		    sizeof(xor_scan_result), xor_scan_worse);
+	}
+
+	if (status == XOR_SCAN_OK && corpus_scan_run_workers(workers,
+		sizeof(*workers), threads, tids, xor_scan_worker_run) != 0) {
+		status = XOR_SCAN_ERR_THREAD;
+	}
+
+	// Reduce: fold every worker heap into the first one.
+	size_t total_skipped = 0;
+	for (size_t t = 0; t < threads && status == XOR_SCAN_OK; ++t) {
+		if (workers[t].status != XOR_SCAN_OK) {
+			status = workers[t].status;
+			break;
+		}
+		total_skipped += workers[t].skipped;
+		if (t > 0) {
+			corpus_scan_heap_merge(&workers[0].heap,
+			    &workers[t].heap);
+		}
+	}
+
+	if (status == XOR_SCAN_OK) {
+		corpus_scan_heap *best = &workers[0].heap;
+		if (!lines) {
+			corpus_scan_number_lines(best, corpus,
+			    offsetof(xor_scan_result, hex),
+			    offsetof(xor_scan_result, line));
+		}
+		corpus_scan_heap_sort(best);
+		memcpy(top, best->items, best->len * sizeof(xor_scan_result));
+		*top_len = best->len;
+		if (skipped) {
+			*skipped = total_skipped;
+		}
+	}
+
+	arena_restore(scratch, mark);
+	return status;
+}
+
+xor_scan_status
+xor_scan_lines(const char *const *lines, size_t count, size_t threads,
+    xor_scan_result *top, size_t top_cap, size_t *top_len, size_t *skipped)
+{
+	if ((!lines && count > 0) || !top || top_cap == 0 || !top_len) {
+		return XOR_SCAN_ERR_ARGS;
+	}
+	if (!lines) {
+		*top_len = 0;
+		if (skipped) {
+			*skipped = 0;
+		}
+		return XOR_SCAN_OK;
+	}
+	return xor_scan_run(lines, count, NULL, threads, top, top_cap,
+	    top_len, skipped);
+}
+
+xor_scan_status
+xor_scan_corpus(const hex_corpus *corpus, size_t threads,
+    xor_scan_result *top, size_t top_cap, size_t *top_len, size_t *skipped)
+{
+	if (!corpus || !top || top_cap == 0 || !top_len) {
+		return XOR_SCAN_ERR_ARGS;
+	}
+	return xor_scan_run(NULL, 0, corpus, threads, top, top_cap, top_len,
+	    skipped);
+}
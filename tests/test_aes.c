@@ -0,0 +1,131 @@
+/**
+ * @file test_aes.c
+ * @brief Unit tests for the AES-128 block cipher.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "aes.h"
+#include "cpu_features.h"
+#include "utest.h"
+
+static const unsigned aes_masks[] = { 0, ~0u };
+
+UTEST(aes128_expand_key, fips197_appendix_a1)
+{
+	const uint8_t key[16] = {
+		0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+		0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+	};
+	const uint8_t last[16] = {
+		0xd0, 0x14, 0xf9, 0xa8, 0xc9, 0xee, 0x25, 0x89,
+		0xe1, 0x3f, 0x0c, 0xc8, 0xb6, 0x63, 0x0c, 0xa6
+	};
+	aes128_key ks;
+
+	ASSERT_EQ(AES_OK, aes128_expand_key(&ks, key));
+	ASSERT_EQ(0, memcmp(key, ks.enc[0], 16));
+	ASSERT_EQ(0, memcmp(last, ks.enc[AES128_ROUNDS], 16));
+	ASSERT_EQ(0, memcmp(last, ks.dec[0], 16));
+	ASSERT_EQ(0, memcmp(key, ks.dec[AES128_ROUNDS], 16));
+}
+
+UTEST(aes128_ecb, fips197_vectors)
+{
+	static const struct
+	{
+		uint8_t key[16];
+		uint8_t plain[16];
+		uint8_t cipher[16];
+	} vectors[] = {
+		{	// Appendix B.
+			{ 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+			  0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c },
+			{ 0x32, 0x43, 0xf6, 0xa8, 0x88, 0x5a, 0x30, 0x8d,
+			  0x31, 0x31, 0x98, 0xa2, 0xe0, 0x37, 0x07, 0x34 },
+			{ 0x39, 0x25, 0x84, 0x1d, 0x02, 0xdc, 0x09, 0xfb,
+			  0xdc, 0x11, 0x85, 0x97, 0x19, 0x6a, 0x0b, 0x32 }
+		},
+		{	// Appendix C.1.
+			{ 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+			  0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f },
+			{ 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+			  0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff },
+			{ 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+			  0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a }
+		}
+	};
+
+	for (size_t m = 0; m < sizeof(aes_masks) / sizeof(aes_masks[0]); ++m) {
+		cpu_features_set_mask(aes_masks[m]);
+		for (size_t v = 0; v < sizeof(vectors) / sizeof(vectors[0]);
+		    ++v) {
+			aes128_key ks;
+			uint8_t out[16];
+			ASSERT_EQ(AES_OK, aes128_expand_key(&ks,
+				vectors[v].key));
+			ASSERT_EQ(AES_OK, aes128_ecb_encrypt(&ks,
+				vectors[v].plain, out, sizeof(out)));
+			ASSERT_EQ(0, memcmp(vectors[v].cipher, out, 16));
+			ASSERT_EQ(AES_OK, aes128_ecb_decrypt(&ks,
+				vectors[v].cipher, out, sizeof(out)));
+			ASSERT_EQ(0, memcmp(vectors[v].plain, out, 16));
+		}
+	}
+	cpu_features_set_mask(~0u);
+}
+
+UTEST(aes128_ecb, multi_block_paths_agree)
+{
+	enum
+	{ BLOCKS = 21 };
+	const uint8_t key[16] = "YELLOW SUBMARINE";
+	uint8_t plain[BLOCKS * 16];
+	uint8_t portable[BLOCKS * 16];
+	uint8_t fast[BLOCKS * 16];
+	aes128_key ks;
+
+	for (size_t i = 0; i < sizeof(plain); ++i) {
+		plain[i] = (uint8_t) (i * 151u + 3u);
+	}
+	ASSERT_EQ(AES_OK, aes128_expand_key(&ks, key));
+
+	for (size_t blocks = 0; blocks <= BLOCKS; ++blocks) {
+		size_t len = blocks * 16;
+		cpu_features_set_mask(0);
+		ASSERT_EQ(AES_OK, aes128_ecb_encrypt(&ks, plain, portable,
+			len));
+		cpu_features_set_mask(~0u);
+		ASSERT_EQ(AES_OK, aes128_ecb_encrypt(&ks, plain, fast, len));
+		ASSERT_EQ(0, memcmp(portable, fast, len));
+
+		// Decrypt in place on both paths.
+		cpu_features_set_mask(0);
+		ASSERT_EQ(AES_OK, aes128_ecb_decrypt(&ks, portable, portable,
+			len));
+		cpu_features_set_mask(~0u);
+		ASSERT_EQ(AES_OK, aes128_ecb_decrypt(&ks, fast, fast, len));
+		ASSERT_EQ(0, memcmp(plain, portable, len));
+		ASSERT_EQ(0, memcmp(plain, fast, len));
+	}
+}
+
+UTEST(aes128_ecb, rejects_bad_arguments)
+{
+	const uint8_t key[16] = { 0 };
+	uint8_t buf[32] = { 0 };
+	aes128_key ks;
+
+	ASSERT_EQ(AES_ERR_ARGS, aes128_expand_key(NULL, key));
+	ASSERT_EQ(AES_ERR_ARGS, aes128_expand_key(&ks, NULL));
+	ASSERT_EQ(AES_OK, aes128_expand_key(&ks, key));
+	ASSERT_EQ(AES_ERR_LENGTH, aes128_ecb_encrypt(&ks, buf, buf, 17));
+	ASSERT_EQ(AES_ERR_ARGS, aes128_ecb_decrypt(&ks, NULL, buf, 16));
+	ASSERT_EQ(AES_ERR_ARGS, aes128_ecb_decrypt(NULL, buf, buf, 16));
+	ASSERT_EQ(AES_OK, aes128_ecb_decrypt(&ks, NULL, NULL, 0));
+	ASSERT_STREQ("length is not a multiple of the AES block size",
+	    aes_status_string(AES_ERR_LENGTH));
+}
+
+UTEST_MAIN();
@@ -0,0 +1,214 @@
+/**
+ * @file test_arena.c
+ * @brief Unit tests for the bump allocator and scratch arenas.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "ecb_detect.h"
+#include "hex2b64.h"
+#include "hex_corpus.h"
+#include "repeat_xor.h"
+#include "utils.h"
+#include "xor_scan.h"
+#include "utest.h"
+
+static size_t count_base;
+
+/* Start counting arena blocks taken from the heap. */
+static void
+count_start(void)
+{
+	count_base = arena_heap_blocks();
+}
+
+static size_t
+count_stop(void)
+{
+	return arena_heap_blocks() - count_base;
+}
+
+UTEST(arena_alloc, honours_alignment_and_restore)
+{
+	arena a = ARENA_INIT;
+	uint8_t *first = arena_alloc(&a, 3, 1);
+	ASSERT_TRUE(first != NULL);
+	memset(first, 0xAA, 3);
+
+	arena_mark mark = arena_save(&a);
+	const size_t aligns[] = { 0, 1, 2, 8, 16, 64 };
+	for (size_t i = 0; i < sizeof(aligns) / sizeof(aligns[0]); ++i) {
+		uint8_t *p = arena_alloc(&a, 5, aligns[i]);
+		ASSERT_TRUE(p != NULL);
+		if (aligns[i] > 1) {
+			ASSERT_EQ((uintptr_t) 0, (uintptr_t) p % aligns[i]);
+		}
+		ASSERT_TRUE(p >= first + 3);
+	}
+
+	arena_restore(&a, mark);
+	ASSERT_EQ((void *) (first + 3), arena_alloc(&a, 1, 1));
+	ASSERT_EQ(0xAA, first[2]);
+
+	ASSERT_TRUE(arena_alloc(&a, 1, 3) == NULL);
+	ASSERT_TRUE(arena_alloc(&a, 1, 2 * ARENA_MAX_ALIGN) == NULL);
+	ASSERT_TRUE(arena_calloc(&a, SIZE_MAX / 2, 4) == NULL);
+	arena_release(&a);
+}
+
+UTEST(arena_alloc, spans_blocks_and_reuses_spares)
+{
+	arena a;
+	arena_init(&a);
+
+	// Overflow the first block and ask for more than any default block.
+	const size_t sizes[] = { 1000, ARENA_MIN_BLOCK, 3 * ARENA_MIN_BLOCK, 7 };
+	uint8_t *ptrs[4];
+	for (size_t i = 0; i < 4; ++i) {
+		ptrs[i] = arena_alloc(&a, sizes[i], 16);
+		ASSERT_TRUE(ptrs[i] != NULL);
+		memset(ptrs[i], (int) i, sizes[i]);
+	}
+	for (size_t i = 0; i < 4; ++i) {
+		ASSERT_EQ((uint8_t) i, ptrs[i][sizes[i] - 1]);
+	}
+
+	arena_reset(&a);
+	count_start();
+	for (size_t i = 0; i < 4; ++i) {
+		ASSERT_TRUE(arena_alloc(&a, sizes[i], 16) != NULL);
+	}
+	ASSERT_EQ((size_t) 0, count_stop());
+
+	// Larger than every spare, so this one has to reach the heap.
+	count_start();
+	ASSERT_TRUE(arena_alloc(&a, 8 * ARENA_MIN_BLOCK, 1) != NULL);
+	ASSERT_EQ((size_t) 1, count_stop());
+
+	uint8_t *zero = arena_calloc(&a, 100, 8);
+	ASSERT_TRUE(zero != NULL);
+	for (size_t i = 0; i < 800; ++i) {
+		ASSERT_EQ(0, zero[i]);
+	}
+	arena_release(&a);
+	ASSERT_TRUE(a.head == NULL);
+	ASSERT_TRUE(a.spare == NULL);
+}
+
+static void *
+scratch_of_thread(void *arg)
+{
+	*(arena **) arg = arena_scratch();
+	return NULL;
+}
+
+UTEST(arena_scratch, one_per_thread)
+{
+	arena *mine = arena_scratch();
+	ASSERT_TRUE(mine != NULL);
+	ASSERT_EQ(mine, arena_scratch());
+
+	arena *theirs = NULL;
+	pthread_t tid;
+	ASSERT_EQ(0, pthread_create(&tid, NULL, scratch_of_thread, &theirs));
+	ASSERT_EQ(0, pthread_join(tid, NULL));
+	ASSERT_TRUE(theirs != NULL);
+	ASSERT_NE(mine, theirs);
+}
+
+/*
+ * Run every scratch-using library path once; the second run must be served
+ * entirely from the blocks the first one left behind.
+ */
+static int
+run_hot_paths(const char *text, size_t text_len, const uint8_t *cipher,
+    size_t cipher_len)
+{
+	hex_corpus corpus;
+	if (hex_corpus_from_buffer(text, text_len, &corpus) != HEX_CORPUS_OK) {
+		return 0;
+	}
+
+	xor_scan_result scan[4];
+	ecb_detect_result ecb[4];
+	repeat_xor_candidate cands[3];
+	size_t n = 0;
+	size_t repeats = 0;
+	// xor_scan_lines() wants NUL-terminated lines, the corpus has none.
+	char first[61];
+	char second[61];
+	memcpy(first, text, 60);
+	memcpy(second, text + 61, 60);
+	first[60] = '\0';
+	second[60] = '\0';
+	const char *lines[] = { first, second };
+	int ok = xor_scan_corpus(&corpus, 1, scan, 4, &n, NULL) ==
+	    XOR_SCAN_OK && xor_scan_lines(lines, 2, 1, scan, 4, &n, NULL) ==
+	    XOR_SCAN_OK && ecb_detect_corpus(&corpus, 1, ecb, 4, &n, NULL) ==
+	    ECB_DETECT_OK && ecb_detect_count_repeats(cipher, cipher_len,
+	    &repeats) == ECB_DETECT_OK && repeat_xor_break(cipher, cipher_len,
+	    2, 40, 1, cands, 3, &n) == REPEAT_XOR_OK;
+
+	uint8_t plain[64];
+	uint8_t key = 0;
+	utils_hex_view views[2] = { { text, 60 }, { text + 61, 60 } };
+	utils_xor_result results[2];
+	ok = ok && brute_force_single_byte_xor_n(text, 60, plain,
+	    sizeof(plain), &n, &key, NULL) == UTILS_OK &&
+	    brute_force_single_byte_xor_batch(views, 2, plain, sizeof(plain),
+	    results) == UTILS_OK;
+
+	uint8_t b64[128];
+	ok = ok && hex2b64_buffer((const uint8_t *) text, 60, b64,
+	    sizeof(b64), NULL) == HEX2B64_OK;
+
+	hex_corpus_close(&corpus);
+	return ok;
+}
+
+UTEST(arena_scratch, hot_paths_stop_allocating_after_warm_up)
+{
+	enum { LINES = 64, LINE_BYTES = 30 };
+	char *text = malloc(LINES * (2 * LINE_BYTES + 1));
+	uint8_t *cipher = malloc(4096);
+	if (!text || !cipher) {
+		free(text);
+		free(cipher);
+		ASSERT_TRUE(0);
+	}
+
+	uint32_t state = 99u;
+	for (size_t i = 0; i < LINES; ++i) {
+		uint8_t bytes[LINE_BYTES];
+		for (size_t j = 0; j < sizeof(bytes); ++j) {
+			state = state * 1103515245u + 12345u;
+			bytes[j] = (uint8_t) (state >> 24);
+		}
+		bytes_to_hex(bytes, sizeof(bytes), text + i * (2 *
+			LINE_BYTES + 1), 2 * LINE_BYTES + 1);
+		text[i * (2 * LINE_BYTES + 1) + 2 * LINE_BYTES] = '\n';
+	}
+	for (size_t i = 0; i < 4096; ++i) {
+		cipher[i] = (uint8_t) ("the quick brown fox "[i % 20] ^
+		    "KEY"[i % 3]);
+	}
+	const size_t text_len = LINES * (2 * LINE_BYTES + 1);
+
+	int warm = run_hot_paths(text, text_len, cipher, 4096);
+	count_start();
+	int ok = run_hot_paths(text, text_len, cipher, 4096);
+	size_t counted = count_stop();
+	free(text);
+	free(cipher);
+
+	ASSERT_TRUE(warm);
+	ASSERT_TRUE(ok);
+	ASSERT_EQ((size_t) 0, counted);
+}
+
+UTEST_MAIN();
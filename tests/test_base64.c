@@ -0,0 +1,198 @@
+/**
+ * @file test_base64.c
+ * @brief Unit tests for the Base64 decoder.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "base64.h"
+#include "cpu_features.h"
+#include "hex2b64.h"
+#include "utest.h"
+
+static base64_status
+decode_string(const char *text, uint8_t *out, size_t out_cap,
+    size_t *out_len, size_t *err_offset)
+{
+	return base64_to_bytes((const uint8_t *) text, strlen(text), out,
+	    out_cap, out_len, err_offset);
+}
+
+UTEST(base64_to_bytes, rfc4648_vectors)
+{
+	static const char *const plain[] = {
+		"", "f", "fo", "foo", "foob", "fooba", "foobar"
+	};
+	static const char *const encoded[] = {
+		"", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy"
+	};
+
+	for (size_t i = 0; i < sizeof(plain) / sizeof(plain[0]); ++i) {
+		uint8_t out[16];
+		size_t out_len = 99;
+		ASSERT_EQ(BASE64_OK, decode_string(encoded[i], out, sizeof(out),
+			&out_len, NULL));
+		ASSERT_EQ(strlen(plain[i]), out_len);
+		ASSERT_EQ(0, memcmp(plain[i], out, out_len));
+	}
+}
+
+UTEST(base64_to_bytes, skips_whitespace)
+{
+	uint8_t out[16];
+	size_t out_len = 0;
+	ASSERT_EQ(BASE64_OK, decode_string(" Zm9v\r\nYm\tFy \n\n", out,
+		sizeof(out), &out_len, NULL));
+	ASSERT_EQ(6u, out_len);
+	ASSERT_EQ(0, memcmp("foobar", out, 6));
+
+	ASSERT_EQ(BASE64_OK, decode_string("Zm8=\n", out, sizeof(out),
+		&out_len, NULL));
+	ASSERT_EQ(2u, out_len);
+}
+
+UTEST(base64_to_bytes, reports_error_offsets)
+{
+	uint8_t out[64];
+	size_t offset = 0;
+
+	ASSERT_EQ(BASE64_ERR_INVALID_CHAR, decode_string("Zm9v!mFy", out,
+		sizeof(out), NULL, &offset));
+	ASSERT_EQ(4u, offset);
+	ASSERT_EQ(BASE64_ERR_BAD_PADDING, decode_string("Zg=a", out,
+		sizeof(out), NULL, &offset));
+	ASSERT_EQ(3u, offset);
+	ASSERT_EQ(BASE64_ERR_BAD_PADDING, decode_string("Zg==Zg==", out,
+		sizeof(out), NULL, &offset));
+	ASSERT_EQ(4u, offset);
+	ASSERT_EQ(BASE64_ERR_BAD_PADDING, decode_string("Z===", out,
+		sizeof(out), NULL, &offset));
+	ASSERT_EQ(1u, offset);
+	ASSERT_EQ(BASE64_ERR_TRUNCATED, decode_string("Zm9vY\n", out,
+		sizeof(out), NULL, &offset));
+	ASSERT_EQ(6u, offset);
+	ASSERT_EQ(BASE64_ERR_OUTPUT_OVERFLOW, decode_string("Zm9vYmFy", out,
+		5, NULL, &offset));
+	ASSERT_EQ(7u, offset);
+	ASSERT_EQ(BASE64_ERR_ARGS, base64_to_bytes(NULL, 4, out,
+		sizeof(out), NULL, NULL));
+}
+
+UTEST(base64_to_bytes, simd_matches_scalar)
+{
+	const unsigned masks[] = { 0, CPU_FEATURE_SSSE3, ~0u };
+	uint8_t bytes[400];
+	uint8_t encoded[600];
+	uint8_t wrapped[700];
+	uint8_t decoded[400 + 8];
+	uint32_t state = 11u;
+
+	for (size_t i = 0; i < sizeof(bytes); ++i) {
+		state = state * 1103515245u + 12345u;
+		bytes[i] = (uint8_t) (state >> 24);
+	}
+
+	for (size_t len = 0; len <= sizeof(bytes); len += 7) {
+		size_t enc_len = 0;
+		ASSERT_EQ(HEX2B64_OK, bytes_to_base64(bytes, len, encoded,
+			sizeof(encoded), &enc_len));
+
+		// Wrap at a line width that varies with the length.
+		size_t width = 40 + len % 37;
+		size_t wrapped_len = 0;
+		for (size_t i = 0; i < enc_len; ++i) {
+			wrapped[wrapped_len++] = encoded[i];
+			if ((i + 1) % width == 0) {
+				wrapped[wrapped_len++] = '\n';
+			}
+		}
+
+		for (size_t m = 0; m < sizeof(masks) / sizeof(masks[0]); ++m) {
+			cpu_features_set_mask(masks[m]);
+			size_t out_len = 0;
+			ASSERT_EQ(BASE64_OK, base64_to_bytes(wrapped,
+				wrapped_len, decoded, sizeof(decoded), &out_len,
+				NULL));
+			ASSERT_EQ(len, out_len);
+			ASSERT_EQ(0, memcmp(bytes, decoded, len));
+
+			// Exact-size output must work as well.
+			ASSERT_EQ(BASE64_OK, base64_to_bytes(encoded, enc_len,
+				decoded, len, &out_len, NULL));
+			ASSERT_EQ(len, out_len);
+
+			// A bad byte deep inside is located exactly.
+			if (enc_len > 10) {
+				size_t at = enc_len - 9;
+				uint8_t saved = encoded[at];
+				size_t offset = 0;
+				encoded[at] = '*';
+				ASSERT_EQ(BASE64_ERR_INVALID_CHAR,
+				    base64_to_bytes(encoded, enc_len, decoded,
+					sizeof(decoded), NULL, &offset));
+				ASSERT_EQ(at, offset);
+				encoded[at] = saved;
+			}
+		}
+	}
+	cpu_features_set_mask(~0u);
+}
+
+UTEST(base64_decode_stream, decodes_across_blocks)
+{
+	const size_t len = 50000;
+	uint8_t *bytes = malloc(len);
+	uint8_t *encoded = malloc(len * 2);
+	uint8_t *decoded = malloc(len + 1);
+	ASSERT_TRUE(bytes != NULL && encoded != NULL && decoded != NULL);
+
+	for (size_t i = 0; i < len; ++i) {
+		bytes[i] = (uint8_t) (i * 131u + (i >> 7));
+	}
+	size_t enc_len = 0;
+	ASSERT_EQ(HEX2B64_OK, bytes_to_base64(bytes, len, encoded, len * 2,
+		&enc_len));
+
+	FILE *in = tmpfile();
+	FILE *out = tmpfile();
+	ASSERT_TRUE(in != NULL && out != NULL);
+	for (size_t i = 0; i < enc_len; i += 60) {
+		size_t n = enc_len - i < 60 ? enc_len - i : 60;
+		fwrite(encoded + i, 1, n, in);
+		fputc('\n', in);
+	}
+	rewind(in);
+
+	ASSERT_EQ(BASE64_OK, base64_decode_stream(in, out, NULL));
+	rewind(out);
+	ASSERT_EQ(len, fread(decoded, 1, len + 1, out));
+	ASSERT_EQ(0, memcmp(bytes, decoded, len));
+
+	// Errors report absolute stream offsets.
+	rewind(in);
+	fseek(in, 40000, SEEK_SET);
+	fputc('#', in);
+	rewind(in);
+	size_t offset = 0;
+	ASSERT_EQ(BASE64_ERR_INVALID_CHAR, base64_decode_stream(in, out,
+		&offset));
+	ASSERT_EQ(40000u, offset);
+
+	fclose(in);
+	fclose(out);
+	free(bytes);
+	free(encoded);
+	free(decoded);
+}
+
+UTEST(base64_decode_stream, null_arguments_rejected)
+{
+	ASSERT_EQ(BASE64_ERR_ARGS, base64_decode_stream(NULL, stdout, NULL));
+	ASSERT_STREQ("truncated Base64 group",
+	    base64_status_string(BASE64_ERR_TRUNCATED));
+}
+
+UTEST_MAIN();
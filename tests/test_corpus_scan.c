@@ -0,0 +1,118 @@
+/**
+ * @file test_corpus_scan.c
+ * @brief Unit tests for the shared top-N heap and scanner scaffolding.
+ */
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "corpus_scan.h"
+#include "hex_corpus.h"
+#include "utest.h"
+
+typedef struct
+{
+	size_t line;
+	const char *hex;
+	int score;
+} scored;
+
+static int
+scored_worse(const void *lhs, const void *rhs)
+{
+	const scored *a = lhs;
+	const scored *b = rhs;
+	if (a->score != b->score) {
+		return a->score < b->score;
+	}
+	return a->hex > b->hex;
+}
+
+UTEST(corpus_scan_heap, keeps_best_and_sorts_them)
+{
+	static const char text[32] = { 0 };
+	scored all[32];
+	uint32_t state = 5u;
+	for (size_t i = 0; i < 32; ++i) {
+		state = state * 1103515245u + 12345u;
+		all[i].line = i;
+		all[i].hex = text + i;
+		all[i].score = (int) ((state >> 16) % 8);
+	}
+
+	// Two partial heaps merged must equal one heap over everything.
+	scored a_items[5];
+	scored b_items[5];
+	corpus_scan_heap a;
+	corpus_scan_heap b;
+	corpus_scan_heap_init(&a, a_items, 5, sizeof(scored), scored_worse);
+	corpus_scan_heap_init(&b, b_items, 5, sizeof(scored), scored_worse);
+	for (size_t i = 0; i < 32; ++i) {
+		corpus_scan_heap_push(i % 3 ? &a : &b, &all[i]);
+	}
+	corpus_scan_heap_merge(&a, &b);
+	corpus_scan_heap_sort(&a);
+	ASSERT_EQ((size_t) 5, a.len);
+
+	// Reference: selection of the five best.
+	int taken[32] = { 0 };
+	for (size_t r = 0; r < 5; ++r) {
+		size_t best = SIZE_MAX;
+		for (size_t i = 0; i < 32; ++i) {
+			if (!taken[i] && (best == SIZE_MAX ||
+				scored_worse(&all[best], &all[i]))) {
+				best = i;
+			}
+		}
+		taken[best] = 1;
+		ASSERT_EQ(all[best].line, a_items[r].line);
+	}
+}
+
+UTEST(corpus_scan_heap, number_lines_counts_non_blank_lines)
+{
+	static const char text[] = "aa\n\nbb\r\ncc\ndd";
+	hex_corpus corpus;
+	ASSERT_EQ(HEX_CORPUS_OK, hex_corpus_from_buffer(text,
+		sizeof(text) - 1, &corpus));
+
+	scored items[3] = {
+		{ SIZE_MAX, text + 11, 1 },
+		{ SIZE_MAX, text + 0, 3 },
+		{ SIZE_MAX, text + 4, 2 },
+	};
+	corpus_scan_heap heap;
+	corpus_scan_heap_init(&heap, items, 3, sizeof(scored), scored_worse);
+	heap.len = 3;
+	corpus_scan_number_lines(&heap, &corpus, offsetof(scored, hex),
+	    offsetof(scored, line));
+	corpus_scan_heap_sort(&heap);
+
+	ASSERT_EQ((size_t) 0, items[0].line);
+	ASSERT_EQ((size_t) 1, items[1].line);
+	ASSERT_EQ((size_t) 3, items[2].line);
+	hex_corpus_close(&corpus);
+}
+
+static void *
+mark_worker(void *arg)
+{
+	*(int *) arg = 1;
+	return NULL;
+}
+
+UTEST(corpus_scan_run_workers, runs_every_worker)
+{
+	int done[4] = { 0 };
+	pthread_t tids[4];
+	ASSERT_EQ(0, corpus_scan_run_workers(done, sizeof(done[0]), 4, tids,
+		mark_worker));
+	for (size_t i = 0; i < 4; ++i) {
+		ASSERT_EQ(1, done[i]);
+	}
+}
+
+UTEST_MAIN();
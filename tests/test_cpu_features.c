@@ -0,0 +1,37 @@
+/**
+ * @file test_cpu_features.c
+ * @brief Unit tests for runtime CPU feature detection.
+ */
+
+#include "cpu_features.h"
+#include "utest.h"
+
+UTEST(cpu_features, mask_restricts_detection)
+{
+	unsigned detected = cpu_features();
+
+	cpu_features_set_mask(0);
+	ASSERT_EQ(0u, cpu_features());
+	ASSERT_TRUE(cpu_has(0));
+	ASSERT_FALSE(cpu_has(CPU_FEATURE_SSE2));
+
+	cpu_features_set_mask(CPU_FEATURE_SSE2);
+	ASSERT_EQ((detected & CPU_FEATURE_SSE2), cpu_features());
+
+	cpu_features_set_mask(~0u);
+	ASSERT_EQ(detected, cpu_features());
+}
+
+UTEST(cpu_features, implied_features)
+{
+	// Every AVX2 CPU also has SSSE3 and SSE2, and every AVX-512 CPU has
+	// AVX2; dispatchers rely on it.
+	if (cpu_has(CPU_FEATURE_AVX2)) {
+		ASSERT_TRUE(cpu_has(CPU_FEATURE_SSSE3 | CPU_FEATURE_SSE2));
+	}
+	if (cpu_has(CPU_FEATURE_AVX512F)) {
+		ASSERT_TRUE(cpu_has(CPU_FEATURE_AVX2));
+	}
+}
+
+UTEST_MAIN();
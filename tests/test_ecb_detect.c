@@ -0,0 +1,158 @@
+/**
+ * @file test_ecb_detect.c
+ * @brief Unit tests for repeated-block ECB detection.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ecb_detect.h"
+#include "utils.h"
+#include "utest.h"
+
+#define CORPUS_LINES 204
+#define LINE_BYTES 160
+
+/*
+ * Build a newline-separated corpus of random 160-byte lines. Line @p target
+ * repeats its first block four times; line @p target + 1 repeats one block
+ * once. A few lines are not valid hex and must be skipped.
+ */
+static char *
+make_corpus(size_t target, size_t *size)
+{
+	char *text = malloc(CORPUS_LINES * (2 * LINE_BYTES + 1) + 1);
+	uint32_t state = 7u;
+	size_t pos = 0;
+
+	for (size_t i = 0; text && i < CORPUS_LINES; ++i) {
+		uint8_t bytes[LINE_BYTES];
+		for (size_t j = 0; j < sizeof(bytes); ++j) {
+			state = state * 1103515245u + 12345u;
+			bytes[j] = (uint8_t) (state >> 24);
+		}
+		if (i == target) {
+			for (size_t b = 2; b < 6; ++b) {
+				memcpy(bytes + 16 * b, bytes, 16);
+			}
+		} else if (i == target + 1) {
+			memcpy(bytes + 16 * 9, bytes + 16 * 3, 16);
+		}
+		bytes_to_hex(bytes, sizeof(bytes), text + pos,
+		    2 * sizeof(bytes) + 1);
+		if (i % 50 == 49) {
+			text[pos + 7] = 'z';
+		}
+		pos += 2 * sizeof(bytes);
+		text[pos++] = '\n';
+	}
+	*size = pos;
+	return text;
+}
+
+UTEST(ecb_detect_count_repeats, counts_whole_blocks_only)
+{
+	uint8_t bytes[16 * 5 + 7];
+	for (size_t i = 0; i < sizeof(bytes); ++i) {
+		bytes[i] = (uint8_t) i;
+	}
+	memcpy(bytes + 32, bytes, 16);
+	memcpy(bytes + 64, bytes, 16);
+	memcpy(bytes + 80, bytes, 7);
+
+	size_t repeats = 99;
+	ASSERT_EQ(ECB_DETECT_OK, ecb_detect_count_repeats(bytes,
+		sizeof(bytes), &repeats));
+	ASSERT_EQ((size_t) 2, repeats);
+
+	ASSERT_EQ(ECB_DETECT_OK, ecb_detect_count_repeats(NULL, 0, &repeats));
+	ASSERT_EQ((size_t) 0, repeats);
+}
+
+UTEST(ecb_detect_corpus, ranks_repeated_lines_first)
+{
+	size_t size = 0;
+	char *text = make_corpus(131, &size);
+	ASSERT_TRUE(text != NULL);
+
+	hex_corpus corpus;
+	ASSERT_EQ(HEX_CORPUS_OK, hex_corpus_from_buffer(text, size, &corpus));
+
+	ecb_detect_result top[3];
+	size_t top_len = 0;
+	size_t skipped = 99;
+	ASSERT_EQ(ECB_DETECT_OK, ecb_detect_corpus(&corpus, 4, top, 3,
+		&top_len, &skipped));
+	ASSERT_EQ((size_t) 3, top_len);
+	ASSERT_EQ((size_t) 4, skipped);
+
+	ASSERT_EQ((size_t) 131, top[0].line);
+	ASSERT_EQ((size_t) 4, top[0].repeats);
+	ASSERT_EQ((size_t) LINE_BYTES / 16, top[0].blocks);
+	ASSERT_EQ((size_t) 2 * LINE_BYTES, top[0].hex_len);
+	ASSERT_EQ(text + 131 * (2 * LINE_BYTES + 1), top[0].hex);
+
+	ASSERT_EQ((size_t) 132, top[1].line);
+	ASSERT_EQ((size_t) 1, top[1].repeats);
+
+	// No other line repeats, so the lowest remaining line is third.
+	ASSERT_EQ((size_t) 0, top[2].line);
+	ASSERT_EQ((size_t) 0, top[2].repeats);
+
+	hex_corpus_close(&corpus);
+	free(text);
+}
+
+UTEST(ecb_detect_corpus, independent_of_thread_count)
+{
+	size_t size = 0;
+	char *text = make_corpus(17, &size);
+	ASSERT_TRUE(text != NULL);
+
+	hex_corpus corpus;
+	ASSERT_EQ(HEX_CORPUS_OK, hex_corpus_from_buffer(text, size, &corpus));
+
+	ecb_detect_result base[8];
+	size_t base_len = 0;
+	ASSERT_EQ(ECB_DETECT_OK, ecb_detect_corpus(&corpus, 1, base, 8,
+		&base_len, NULL));
+
+	const size_t threads[] = { 3, 7, 0 };
+	for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); ++t) {
+		ecb_detect_result top[8];
+		size_t top_len = 0;
+		ASSERT_EQ(ECB_DETECT_OK, ecb_detect_corpus(&corpus,
+			threads[t], top, 8, &top_len, NULL));
+		ASSERT_EQ(base_len, top_len);
+		for (size_t i = 0; i < top_len; ++i) {
+			ASSERT_EQ(base[i].line, top[i].line);
+			ASSERT_EQ(base[i].repeats, top[i].repeats);
+		}
+	}
+
+	hex_corpus_close(&corpus);
+	free(text);
+}
+
+UTEST(ecb_detect_corpus, rejects_bad_arguments)
+{
+	hex_corpus corpus;
+	ASSERT_EQ(HEX_CORPUS_OK, hex_corpus_from_buffer("00\n", 3, &corpus));
+
+	ecb_detect_result top[1];
+	size_t top_len = 0;
+	ASSERT_EQ(ECB_DETECT_ERR_ARGS, ecb_detect_corpus(NULL, 1, top, 1,
+		&top_len, NULL));
+	ASSERT_EQ(ECB_DETECT_ERR_ARGS, ecb_detect_corpus(&corpus, 1, top, 0,
+		&top_len, NULL));
+	ASSERT_EQ(ECB_DETECT_ERR_ARGS, ecb_detect_corpus(&corpus, 1, NULL, 1,
+		&top_len, NULL));
+	ASSERT_EQ(ECB_DETECT_ERR_ARGS, ecb_detect_count_repeats(NULL, 16,
+		&top_len));
+
+	hex_corpus_close(&corpus);
+}
+
+UTEST_MAIN();
@@ -5,8 +5,11 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
+#include "cpu_features.h"
 #include "fixed_xor.h"
 #include "utest.h"
 
@@ -47,6 +50,52 @@ UTEST(fixed_xor_buffers, allows_output_alias)
 	ASSERT_EQ(0, memcmp(data, expected, sizeof(expected)));
 }
 
+UTEST(fixed_xor_buffers, simd_matches_bytewise_at_all_alignments)
+{
+	const unsigned masks[] = {
+		0, CPU_FEATURE_SSE2, CPU_FEATURE_SSE2 | CPU_FEATURE_AVX2, ~0u
+	};
+	enum
+	{ MAX_LEN = 700 };
+	uint8_t lhs[MAX_LEN + 64];
+	uint8_t rhs[MAX_LEN + 64];
+	uint8_t out[MAX_LEN + 64];
+	uint8_t inplace[MAX_LEN + 64];
+
+	for (size_t i = 0; i < sizeof(lhs); ++i) {
+		lhs[i] = (uint8_t) (i * 37u + 11u);
+		rhs[i] = (uint8_t) (i * 101u ^ 0x5Au);
+	}
+
+	for (size_t m = 0; m < sizeof(masks) / sizeof(masks[0]); ++m) {
+		cpu_features_set_mask(masks[m]);
+		for (size_t len = 0; len <= MAX_LEN; len += 13) {
+			for (size_t off = 0; off < 64; off += 7) {
+				memset(out, 0xCC, sizeof(out));
+				ASSERT_EQ(FIXED_XOR_OK, fixed_xor_buffers(
+				    lhs + (off + 3) % 64, rhs + off,
+				    out + off, len));
+				for (size_t i = 0; i < len; ++i) {
+					ASSERT_EQ((uint8_t) (lhs[(off + 3) %
+					    64 + i] ^ rhs[off + i]),
+					    out[off + i]);
+				}
+				ASSERT_EQ(0xCC, out[off + len]);
+
+				memcpy(inplace, lhs, sizeof(inplace));
+				ASSERT_EQ(FIXED_XOR_OK, fixed_xor_buffers(
+				    inplace + off, rhs + off, inplace + off,
+				    len));
+				for (size_t i = 0; i < len; ++i) {
+					ASSERT_EQ((uint8_t) (lhs[off + i] ^
+					    rhs[off + i]), inplace[off + i]);
+				}
+			}
+		}
+	}
+	cpu_features_set_mask(~0u);
+}
+
 UTEST(fixed_xor_buffers, null_pointer_rejected)
 {
 	uint8_t lhs = 0x01;
@@ -190,26 +239,138 @@ UTEST(fixed_xor_stream, rejects_null_arguments)
 
 UTEST(fixed_xor_stream, simulated_allocation_failure)
 {
-	FILE *in = tmpfile();
+	// Only a non-seekable input is buffered, and it only grows past the
+	// first chunk, so feed a pipe with more than that.
+	int fds[2];
+	ASSERT_EQ(0, pipe(fds));
+	uint8_t data[8192];
+	memset(data, 0x5a, sizeof(data));
+	ASSERT_EQ((ssize_t) sizeof(data), write(fds[1], data, sizeof(data)));
+	close(fds[1]);
+
+	FILE *in = fdopen(fds[0], "rb");
 	FILE *out = tmpfile();
 	ASSERT_TRUE(in != NULL);
 	ASSERT_TRUE(out != NULL);
 
-	const uint8_t lhs[] = { 0x01, 0x02 };
-	const uint8_t rhs[] = { 0x03, 0x04 };
-	ASSERT_EQ(sizeof(lhs), fwrite(lhs, 1, sizeof(lhs), in));
-	ASSERT_EQ(sizeof(rhs), fwrite(rhs, 1, sizeof(rhs), in));
-	rewind(in);
-
 	fixed_xor_set_allocation_failure(1);
 	fixed_xor_status status = fixed_xor_stream(in, out);
 	fixed_xor_set_allocation_failure(0);
+	fclose(in);
+	fclose(out);
 	ASSERT_EQ(FIXED_XOR_ERR_OOM, status);
+}
+
+UTEST(fixed_xor_stream, split_starts_at_stream_position)
+{
+	FILE *in = tmpfile();
+	FILE *out = tmpfile();
+	ASSERT_TRUE(in != NULL);
+	ASSERT_TRUE(out != NULL);
+
+	const uint8_t data[] = { 0xEE, 0x0F, 0xF0, 0x01, 0x02 };
+	ASSERT_EQ(sizeof(data), fwrite(data, 1, sizeof(data), in));
+	rewind(in);
+	ASSERT_EQ(0xEE, fgetc(in));
+
+	ASSERT_EQ(FIXED_XOR_OK, fixed_xor_stream(in, out));
+	ASSERT_EQ(EOF, fgetc(in));
+
+	rewind(out);
+	uint8_t buf[4];
+	ASSERT_EQ(2u, fread(buf, 1, sizeof(buf), out));
+	ASSERT_EQ(0x0E, buf[0]);
+	ASSERT_EQ(0xF2, buf[1]);
 
 	fclose(in);
 	fclose(out);
 }
 
+UTEST(fixed_xor_stream, pipe_input_falls_back_to_buffering)
+{
+	int fds[2];
+	ASSERT_EQ(0, pipe(fds));
+	const uint8_t data[] = { 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB };
+	ASSERT_EQ((ssize_t) sizeof(data), write(fds[1], data, sizeof(data)));
+	close(fds[1]);
+
+	FILE *in = fdopen(fds[0], "rb");
+	FILE *out = tmpfile();
+	ASSERT_TRUE(in != NULL);
+	ASSERT_TRUE(out != NULL);
+
+	ASSERT_EQ(FIXED_XOR_OK, fixed_xor_stream(in, out));
+
+	rewind(out);
+	uint8_t buf[4];
+	ASSERT_EQ(3u, fread(buf, 1, sizeof(buf), out));
+	const uint8_t expected[] = { 0x01 ^ 0x67, 0x23 ^ 0x89, 0x45 ^ 0xAB };
+	ASSERT_EQ(0, memcmp(buf, expected, sizeof(expected)));
+
+	fclose(in);
+	fclose(out);
+}
+
+UTEST(fixed_xor_stream_pair, xors_across_blocks)
+{
+	const size_t len = 200003;
+	uint8_t *lhs = malloc(len);
+	uint8_t *rhs = malloc(len);
+	uint8_t *buf = malloc(len + 1);
+	ASSERT_TRUE(lhs != NULL && rhs != NULL && buf != NULL);
+	for (size_t i = 0; i < len; ++i) {
+		lhs[i] = (uint8_t) (i * 7u);
+		rhs[i] = (uint8_t) (i >> 3);
+	}
+
+	FILE *lf = tmpfile();
+	FILE *rf = tmpfile();
+	FILE *out = tmpfile();
+	ASSERT_TRUE(lf != NULL && rf != NULL && out != NULL);
+	ASSERT_EQ(len, fwrite(lhs, 1, len, lf));
+	ASSERT_EQ(len, fwrite(rhs, 1, len, rf));
+	rewind(lf);
+	rewind(rf);
+
+	ASSERT_EQ(FIXED_XOR_OK, fixed_xor_stream_pair(lf, rf, out));
+
+	rewind(out);
+	ASSERT_EQ(len, fread(buf, 1, len + 1, out));
+	for (size_t i = 0; i < len; ++i) {
+		ASSERT_EQ((uint8_t) (lhs[i] ^ rhs[i]), buf[i]);
+	}
+
+	fclose(lf);
+	fclose(rf);
+	fclose(out);
+	free(lhs);
+	free(rhs);
+	free(buf);
+}
+
+UTEST(fixed_xor_stream_pair, length_mismatch_detected)
+{
+	FILE *lf = tmpfile();
+	FILE *rf = tmpfile();
+	FILE *out = tmpfile();
+	ASSERT_TRUE(lf != NULL && rf != NULL && out != NULL);
+
+	const uint8_t lhs[] = { 0x01, 0x02, 0x03 };
+	const uint8_t rhs[] = { 0x01, 0x02 };
+	ASSERT_EQ(sizeof(lhs), fwrite(lhs, 1, sizeof(lhs), lf));
+	ASSERT_EQ(sizeof(rhs), fwrite(rhs, 1, sizeof(rhs), rf));
+	rewind(lf);
+	rewind(rf);
+
+	ASSERT_EQ(FIXED_XOR_ERR_LENGTH_MISMATCH,
+	    fixed_xor_stream_pair(lf, rf, out));
+	ASSERT_EQ(FIXED_XOR_ERR_ARGS, fixed_xor_stream_pair(lf, NULL, out));
+
+	fclose(lf);
+	fclose(rf);
+	fclose(out);
+}
+
 UTEST(fixed_xor_status_string, returns_text)
 {
 	ASSERT_STREQ("success", fixed_xor_status_string(FIXED_XOR_OK));
@@ -220,6 +381,8 @@ UTEST(fixed_xor_status_string, returns_text)
 	    fixed_xor_status_string(FIXED_XOR_ERR_ODD_INPUT));
 	ASSERT_STREQ("out of memory",
 	    fixed_xor_status_string(FIXED_XOR_ERR_OOM));
+	ASSERT_STREQ("inputs differ in length",
+	    fixed_xor_status_string(FIXED_XOR_ERR_LENGTH_MISMATCH));
 }
 
 UTEST_MAIN();
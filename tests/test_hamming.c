@@ -0,0 +1,115 @@
+/**
+ * @file test_hamming.c
+ * @brief Unit tests for Hamming distance.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "cpu_features.h"
+#include "hamming.h"
+#include "utest.h"
+
+static uint64_t
+naive_distance(const uint8_t *a, const uint8_t *b, size_t len)
+{
+	uint64_t bits = 0;
+	for (size_t i = 0; i < len; ++i) {
+		for (uint8_t x = a[i] ^ b[i]; x != 0; x >>= 1) {
+			bits += x & 1u;
+		}
+	}
+	return bits;
+}
+
+UTEST(hamming_distance, cryptopals_vector)
+{
+	const char a[] = "this is a test";
+	const char b[] = "wokka wokka!!!";
+	uint64_t bits = 0;
+
+	ASSERT_EQ(HAMMING_OK, hamming_distance((const uint8_t *) a,
+		(const uint8_t *) b, sizeof(a) - 1, &bits));
+	ASSERT_EQ(37u, bits);
+}
+
+UTEST(hamming_distance, kernels_match_naive)
+{
+	const unsigned masks[] = {
+		0, CPU_FEATURE_POPCNT, CPU_FEATURE_POPCNT | CPU_FEATURE_AVX2,
+		~0u
+	};
+	enum
+	{ MAX_LEN = 2100 };
+	static uint8_t a[MAX_LEN + 8];
+	static uint8_t b[MAX_LEN + 8];
+	uint32_t state = 3u;
+
+	for (size_t i = 0; i < sizeof(a); ++i) {
+		state = state * 1103515245u + 12345u;
+		a[i] = (uint8_t) (state >> 24);
+		state = state * 1103515245u + 12345u;
+		b[i] = (uint8_t) (state >> 24);
+	}
+	// A run of all-different bytes drives every Harley-Seal counter.
+	memset(a + 600, 0xFF, 600);
+	memset(b + 600, 0x00, 600);
+
+	for (size_t m = 0; m < sizeof(masks) / sizeof(masks[0]); ++m) {
+		cpu_features_set_mask(masks[m]);
+		for (size_t len = 0; len <= MAX_LEN; len += 31) {
+			for (size_t off = 0; off < 8; off += 3) {
+				uint64_t bits = 0;
+				ASSERT_EQ(HAMMING_OK, hamming_distance(a + off,
+				    b, len, &bits));
+				ASSERT_EQ(naive_distance(a + off, b, len),
+				    bits);
+			}
+		}
+	}
+	cpu_features_set_mask(~0u);
+}
+
+UTEST(hamming_distance_batch, matches_single_calls)
+{
+	enum
+	{ COUNT = 5, LEN = 777 };
+	static uint8_t data[COUNT + 1][LEN];
+	for (size_t i = 0; i <= COUNT; ++i) {
+		for (size_t j = 0; j < LEN; ++j) {
+			data[i][j] = (uint8_t) (i * 53u + j * (i + 1u));
+		}
+	}
+	const uint8_t *items[COUNT];
+	for (size_t i = 0; i < COUNT; ++i) {
+		items[i] = data[i + 1];
+	}
+
+	uint64_t batch[COUNT];
+	ASSERT_EQ(HAMMING_OK, hamming_distance_batch(data[0], items, COUNT,
+		LEN, batch));
+	for (size_t i = 0; i < COUNT; ++i) {
+		uint64_t bits = 0;
+		ASSERT_EQ(HAMMING_OK, hamming_distance(data[0], items[i], LEN,
+			&bits));
+		ASSERT_EQ(bits, batch[i]);
+	}
+}
+
+UTEST(hamming_distance, rejects_bad_arguments)
+{
+	const uint8_t byte = 0;
+	uint64_t bits = 0;
+	const uint8_t *items[1] = { NULL };
+
+	ASSERT_EQ(HAMMING_ERR_ARGS, hamming_distance(NULL, &byte, 1, &bits));
+	ASSERT_EQ(HAMMING_ERR_ARGS, hamming_distance(&byte, &byte, 1, NULL));
+	ASSERT_EQ(HAMMING_OK, hamming_distance(NULL, NULL, 0, &bits));
+	ASSERT_EQ(0u, bits);
+	ASSERT_EQ(HAMMING_ERR_ARGS, hamming_distance_batch(&byte, items, 1, 1,
+		&bits));
+	ASSERT_STREQ("invalid arguments",
+	    hamming_status_string(HAMMING_ERR_ARGS));
+}
+
+UTEST_MAIN();
@@ -5,8 +5,10 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include "cpu_features.h"
 #include "hex2b64.h"
 #include "utest.h"
 
@@ -152,6 +154,22 @@ UTEST(stream_edge, invalid_char_in_middle)
 	ASSERT_EQ(HEX2B64_ERR_INVALID_HEX, status);
 }
 
+/* Groups before an invalid character are still written. */
+UTEST(stream_edge, invalid_char_keeps_prefix_output)
+{
+	char out[128];
+	// "ManManManMan" in hex, then the partial group "Ma" and a bad pair.
+	hex2b64_status status =
+	    convert_hex_string("4d616e4d616e4d616e4d616e4d61zz", out,
+	    sizeof(out));
+	ASSERT_EQ(HEX2B64_ERR_INVALID_HEX, status);
+	ASSERT_STREQ("TWFuTWFuTWFuTWFu", out);
+
+	status = convert_hex_string("4d616e4z616e", out, sizeof(out));
+	ASSERT_EQ(HEX2B64_ERR_INVALID_HEX, status);
+	ASSERT_STREQ("TWFu", out);
+}
+
 /* Invalid hex character as first non-whitespace: error. */
 UTEST(stream_edge, invalid_first_char)
 {
@@ -184,6 +202,112 @@ UTEST(stream_edge, many_bytes_sanity)
 	ASSERT_EQ('\n', out[len - 1]);
 }
 
+/* Inputs spanning many read blocks, with whitespace and odd splits. */
+UTEST(stream_edge, large_input_matches_buffer)
+{
+	const size_t hex_cap = 100000;
+	char *hex = malloc(hex_cap + 2);
+	uint8_t *expected = malloc(hex_cap);
+	char *actual = malloc(hex_cap);
+	ASSERT_TRUE(hex != NULL && expected != NULL && actual != NULL);
+
+	uint32_t state = 99u;
+	size_t digits = 0;
+	for (size_t i = 0; i < hex_cap; ++i) {
+		state = state * 1103515245u + 12345u;
+		unsigned r = state >> 24;
+		if (r < 24) {
+			hex[i] = " \t\r\n\v\f"[r % 6];
+		} else {
+			hex[i] = "0123456789abcdefABCDEF"[r % 22];
+			digits++;
+		}
+	}
+	// Keep an even digit count so the input is valid.
+	size_t len = hex_cap;
+	if (digits & 1U) {
+		hex[len++] = '0';
+	}
+	hex[len] = '\0';
+
+	size_t expected_len = 0;
+	ASSERT_EQ(HEX2B64_OK, hex2b64_buffer((const uint8_t *) hex, len,
+		expected, hex_cap, &expected_len));
+	ASSERT_EQ(HEX2B64_OK, convert_hex_string(hex, actual, hex_cap));
+	ASSERT_EQ(expected_len, strlen(actual));
+	ASSERT_EQ(0, memcmp(expected, actual, expected_len));
+
+	// An invalid digit deep inside a later block is still caught.
+	hex[hex_cap - 10] = 'x';
+	ASSERT_EQ(HEX2B64_ERR_INVALID_HEX,
+	    convert_hex_string(hex, actual, hex_cap));
+
+	free(hex);
+	free(expected);
+	free(actual);
+}
+
+/* === Tests for bytes_to_base64 === */
+
+UTEST(bytes_to_base64, rfc4648_vectors)
+{
+	static const char *const plain[] = {
+		"", "f", "fo", "foo", "foob", "fooba", "foobar"
+	};
+	static const char *const encoded[] = {
+		"", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy"
+	};
+
+	for (size_t i = 0; i < sizeof(plain) / sizeof(plain[0]); ++i) {
+		uint8_t out[16];
+		size_t out_len = 99;
+		ASSERT_EQ(HEX2B64_OK, bytes_to_base64((const uint8_t *) plain[i],
+			strlen(plain[i]), out, sizeof(out), &out_len));
+		ASSERT_EQ(strlen(encoded[i]), out_len);
+		ASSERT_EQ(0, memcmp(encoded[i], out, out_len));
+	}
+}
+
+UTEST(bytes_to_base64, simd_matches_scalar)
+{
+	const unsigned masks[] = { CPU_FEATURE_SSSE3, ~0u };
+	uint8_t bytes[300];
+	uint8_t scalar[400];
+	uint8_t simd[400];
+	uint32_t state = 5u;
+
+	for (size_t i = 0; i < sizeof(bytes); ++i) {
+		state = state * 1103515245u + 12345u;
+		bytes[i] = (uint8_t) (state >> 24);
+	}
+
+	for (size_t len = 0; len <= sizeof(bytes); ++len) {
+		size_t scalar_len = 0;
+		cpu_features_set_mask(0);
+		ASSERT_EQ(HEX2B64_OK, bytes_to_base64(bytes, len, scalar,
+			sizeof(scalar), &scalar_len));
+		for (size_t m = 0; m < sizeof(masks) / sizeof(masks[0]); ++m) {
+			size_t simd_len = 0;
+			cpu_features_set_mask(masks[m]);
+			ASSERT_EQ(HEX2B64_OK, bytes_to_base64(bytes, len, simd,
+				sizeof(simd), &simd_len));
+			ASSERT_EQ(scalar_len, simd_len);
+			ASSERT_EQ(0, memcmp(scalar, simd, scalar_len));
+		}
+	}
+	cpu_features_set_mask(~0u);
+}
+
+UTEST(bytes_to_base64, rejects_small_output)
+{
+	uint8_t out[4];
+	ASSERT_EQ(HEX2B64_ERR_OUTPUT_OVERFLOW,
+	    bytes_to_base64((const uint8_t *) "abcd", 4, out, sizeof(out),
+		NULL));
+	ASSERT_EQ(HEX2B64_ERR_ARGS, bytes_to_base64(NULL, 1, out,
+		sizeof(out), NULL));
+}
+
 /* === Tests for hex2b64_buffer === */
 
 UTEST(buffer, hello_world_plain)
@@ -260,6 +384,25 @@ UTEST(buffer_edge, insufficient_output_capacity)
 	ASSERT_EQ(HEX2B64_ERR_OUTPUT_OVERFLOW, status);
 }
 
+UTEST(buffer_edge, overflow_before_invalid_character_wins)
+{
+	uint8_t out[6];
+	size_t out_len = 0;
+	hex2b64_status status = convert_hex_buffer("4d616e4d616ezz",
+	    out,
+	    sizeof(out),
+	    &out_len);
+	ASSERT_EQ(HEX2B64_ERR_OUTPUT_OVERFLOW, status);
+	ASSERT_EQ(0, memcmp("TWFu", out, 4));
+
+	// With room for the valid groups the bad digit is reported.
+	uint8_t wide[16];
+	status = convert_hex_buffer("4d616e4d616ezz", wide, sizeof(wide),
+	    &out_len);
+	ASSERT_EQ(HEX2B64_ERR_INVALID_HEX, status);
+	ASSERT_EQ(0, memcmp("TWFuTWFu", wide, 8));
+}
+
 UTEST(buffer_edge, null_output)
 {
 	size_t out_len = 0;
@@ -0,0 +1,109 @@
+/**
+ * @file test_hex_corpus.c
+ * @brief Unit tests for the memory-mapped hex corpus reader.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hex_corpus.h"
+#include "utest.h"
+
+static const char sample[] = "aa\nbbbb\r\n\n\r\ncc\ndddddd";
+
+UTEST(hex_corpus_next, yields_views_without_terminators)
+{
+	hex_corpus corpus;
+	ASSERT_EQ(HEX_CORPUS_OK,
+	    hex_corpus_from_buffer(sample, strlen(sample), &corpus));
+
+	hex_corpus_cursor cursor;
+	hex_corpus_line line;
+	hex_corpus_shard(&corpus, 0, 1, &cursor);
+
+	const char *expected[] = { "aa", "bbbb", "cc", "dddddd" };
+	for (size_t i = 0; i < 4; ++i) {
+		ASSERT_EQ(1, hex_corpus_next(&cursor, &line));
+		ASSERT_EQ(strlen(expected[i]), line.len);
+		ASSERT_EQ(0, memcmp(expected[i], line.data, line.len));
+	}
+	ASSERT_EQ(0, hex_corpus_next(&cursor, &line));
+}
+
+UTEST(hex_corpus_shard, every_line_visited_once)
+{
+	hex_corpus corpus;
+	ASSERT_EQ(HEX_CORPUS_OK,
+	    hex_corpus_from_buffer(sample, strlen(sample), &corpus));
+
+	for (size_t shards = 1; shards <= strlen(sample) + 2; ++shards) {
+		size_t lines = 0;
+		size_t chars = 0;
+		const char *last = NULL;
+		for (size_t s = 0; s < shards; ++s) {
+			hex_corpus_cursor cursor;
+			hex_corpus_line line;
+			hex_corpus_shard(&corpus, s, shards, &cursor);
+			while (hex_corpus_next(&cursor, &line)) {
+				ASSERT_TRUE(last == NULL || line.data > last);
+				last = line.data;
+				lines++;
+				chars += line.len;
+			}
+		}
+		ASSERT_EQ(4u, lines);
+		ASSERT_EQ(14u, chars);
+	}
+}
+
+UTEST(hex_corpus_open, maps_file)
+{
+	char path[] = "/tmp/hex_corpus_testXXXXXX";
+	int fd = mkstemp(path);
+	ASSERT_TRUE(fd >= 0);
+	FILE *file = fdopen(fd, "w");
+	ASSERT_TRUE(file != NULL);
+	fputs("0102\n0304\n", file);
+	fclose(file);
+
+	hex_corpus corpus;
+	ASSERT_EQ(HEX_CORPUS_OK, hex_corpus_open(path, &corpus));
+	ASSERT_EQ(10u, corpus.size);
+
+	hex_corpus_cursor cursor;
+	hex_corpus_line line;
+	hex_corpus_shard(&corpus, 0, 1, &cursor);
+	ASSERT_EQ(1, hex_corpus_next(&cursor, &line));
+	ASSERT_EQ(0, memcmp("0102", line.data, 4));
+	ASSERT_EQ(1, hex_corpus_next(&cursor, &line));
+	ASSERT_EQ(0, memcmp("0304", line.data, 4));
+	ASSERT_EQ(0, hex_corpus_next(&cursor, &line));
+
+	hex_corpus_close(&corpus);
+	remove(path);
+}
+
+UTEST(hex_corpus_open, empty_file_and_errors)
+{
+	char path[] = "/tmp/hex_corpus_testXXXXXX";
+	int fd = mkstemp(path);
+	ASSERT_TRUE(fd >= 0);
+	close(fd);
+
+	hex_corpus corpus;
+	ASSERT_EQ(HEX_CORPUS_OK, hex_corpus_open(path, &corpus));
+	hex_corpus_cursor cursor;
+	hex_corpus_line line;
+	hex_corpus_shard(&corpus, 0, 1, &cursor);
+	ASSERT_EQ(0, hex_corpus_next(&cursor, &line));
+	hex_corpus_close(&corpus);
+	remove(path);
+
+	ASSERT_EQ(HEX_CORPUS_ERR_IO,
+	    hex_corpus_open("/nonexistent/hex_corpus", &corpus));
+	ASSERT_EQ(HEX_CORPUS_ERR_ARGS, hex_corpus_open(NULL, &corpus));
+}
+
+UTEST_MAIN();
@@ -0,0 +1,218 @@
+/**
+ * @file test_repeat_xor.c
+ * @brief Unit tests for repeating-key XOR.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "repeat_xor.h"
+#include "utest.h"
+
+static void
+naive_repeat_xor(const uint8_t *in, uint8_t *out, size_t len,
+    const uint8_t *key, size_t key_len)
+{
+	for (size_t i = 0; i < len; ++i) {
+		out[i] = in[i] ^ key[i % key_len];
+	}
+}
+
+UTEST(repeating_key_xor, cryptopals_vector)
+{
+	const char plain[] = "Burning 'em, if you ain't quick and nimble";
+	const uint8_t expected[] = {
+		0x0b, 0x36, 0x37, 0x27, 0x2a, 0x2b, 0x2e, 0x63, 0x62, 0x2c,
+		0x2e, 0x69, 0x69, 0x2a, 0x23, 0x69, 0x3a, 0x2a, 0x3c, 0x63,
+		0x24, 0x20, 0x2d, 0x62, 0x3d, 0x63, 0x34, 0x3c, 0x2a, 0x26,
+		0x22, 0x63, 0x24, 0x27, 0x27, 0x65, 0x27, 0x2a, 0x28, 0x2b,
+		0x2f, 0x20
+	};
+	uint8_t out[sizeof(plain) - 1];
+
+	ASSERT_EQ(REPEAT_XOR_OK, repeating_key_xor((const uint8_t *) plain,
+		out, sizeof(out), (const uint8_t *) "ICE", 3));
+	ASSERT_EQ(0, memcmp(expected, out, sizeof(expected)));
+}
+
+UTEST(repeating_key_xor, matches_naive_for_many_key_lengths)
+{
+	enum
+	{ LEN = 9000 };
+	uint8_t *in = malloc(LEN);
+	uint8_t *key = malloc(LEN);
+	uint8_t *want = malloc(LEN);
+	uint8_t *got = malloc(LEN);
+	ASSERT_TRUE(in && key && want && got);
+	for (size_t i = 0; i < LEN; ++i) {
+		in[i] = (uint8_t) (i * 29u + 7u);
+		key[i] = (uint8_t) (i * 113u ^ 0x3Cu);
+	}
+
+	const size_t key_lens[] = {
+		1, 2, 3, 5, 7, 16, 29, 31, 32, 33, 40, 64, 100, 4095, 4096,
+		4097, 5000, LEN
+	};
+	for (size_t k = 0; k < sizeof(key_lens) / sizeof(key_lens[0]); ++k) {
+		naive_repeat_xor(in, want, LEN, key, key_lens[k]);
+		ASSERT_EQ(REPEAT_XOR_OK, repeating_key_xor(in, got, LEN, key,
+			key_lens[k]));
+		ASSERT_EQ(0, memcmp(want, got, LEN));
+
+		// In place.
+		memcpy(got, in, LEN);
+		ASSERT_EQ(REPEAT_XOR_OK, repeating_key_xor(got, got, LEN, key,
+			key_lens[k]));
+		ASSERT_EQ(0, memcmp(want, got, LEN));
+	}
+
+	free(in);
+	free(key);
+	free(want);
+	free(got);
+}
+
+UTEST(repeat_xor_update, chunked_stream_matches_one_shot)
+{
+	enum
+	{ LEN = 20000 };
+	uint8_t *in = malloc(LEN);
+	uint8_t *want = malloc(LEN);
+	uint8_t *got = malloc(LEN);
+	ASSERT_TRUE(in && want && got);
+	for (size_t i = 0; i < LEN; ++i) {
+		in[i] = (uint8_t) (i ^ (i >> 8));
+	}
+
+	const uint8_t key[] = "a key of 23 characters!";
+	const size_t key_lens[] = { 1, 3, 23 };
+	for (size_t k = 0; k < sizeof(key_lens) / sizeof(key_lens[0]); ++k) {
+		naive_repeat_xor(in, want, LEN, key, key_lens[k]);
+
+		repeat_xor_ctx ctx;
+		ASSERT_EQ(REPEAT_XOR_OK, repeat_xor_init(&ctx, key,
+			key_lens[k]));
+		size_t pos = 0;
+		uint32_t state = 5u;
+		while (pos < LEN) {
+			state = state * 1103515245u + 12345u;
+			size_t n = (state >> 16) % 6000;
+			if (n > LEN - pos) {
+				n = LEN - pos;
+			}
+			ASSERT_EQ(REPEAT_XOR_OK, repeat_xor_update(&ctx,
+				in + pos, got + pos, n));
+			pos += n;
+		}
+		ASSERT_EQ(0, memcmp(want, got, LEN));
+	}
+
+	free(in);
+	free(want);
+	free(got);
+}
+
+UTEST(repeating_key_xor, rejects_bad_arguments)
+{
+	uint8_t buf[4] = { 0 };
+	const uint8_t key[] = { 0x01 };
+	repeat_xor_ctx ctx;
+
+	ASSERT_EQ(REPEAT_XOR_ERR_ARGS, repeating_key_xor(buf, buf,
+		sizeof(buf), key, 0));
+	ASSERT_EQ(REPEAT_XOR_ERR_ARGS, repeating_key_xor(buf, buf,
+		sizeof(buf), NULL, 1));
+	ASSERT_EQ(REPEAT_XOR_ERR_ARGS, repeating_key_xor(NULL, buf,
+		sizeof(buf), key, 1));
+	ASSERT_EQ(REPEAT_XOR_OK, repeating_key_xor(NULL, NULL, 0, key, 1));
+	ASSERT_EQ(REPEAT_XOR_ERR_ARGS, repeat_xor_init(&ctx, NULL, 1));
+	ASSERT_STREQ("invalid arguments",
+	    repeat_xor_status_string(REPEAT_XOR_ERR_ARGS));
+}
+
+static const char english_text[] =
+    "It was the best of times, it was the worst of times, it was the age "
+    "of wisdom, it was the age of foolishness, it was the epoch of belief, "
+    "it was the epoch of incredulity, it was the season of Light, it was "
+    "the season of Darkness, it was the spring of hope, it was the winter "
+    "of despair, we had everything before us, we had nothing before us, we "
+    "were all going direct to Heaven, we were all going direct the other "
+    "way. In short, the period was so far like the present period, that "
+    "some of its noisiest authorities insisted on its being received, for "
+    "good or for evil, in the superlative degree of comparison only. "
+    "There were a king with a large jaw and a queen with a plain face, on "
+    "the throne of England; there were a king with a large jaw and a queen "
+    "with a fair face, on the throne of France. In both countries it was "
+    "clearer than crystal to the lords of the State preserves of loaves "
+    "and fishes, that things in general were settled for ever. It was the "
+    "year of Our Lord one thousand seven hundred and seventy five. "
+    "Spiritual revelations were conceded to England at that favoured "
+    "period, as at this. Mrs. Southcott had recently attained her five and "
+    "twentieth blessed birthday, of whom a prophetic private in the Life "
+    "Guards had heralded the sublime appearance by announcing that "
+    "arrangements were made for the swallowing up of London and "
+    "Westminster. Even the Cock lane ghost had been laid only a round "
+    "dozen of years, after rapping out its messages, as the spirits of "
+    "this very year last past rapped out theirs. Mere messages in the "
+    "earthly order of events had lately come to the English Crown and "
+    "People, from a congress of British subjects in America: which, "
+    "strange to relate, have proved more important to the human race than "
+    "any communications yet received through any of the chickens of the "
+    "Cock lane brood. France, less favoured on the whole as to matters "
+    "spiritual than her sister of the shield and trident, rolled with "
+    "exceeding smoothness down hill, making paper money and spending it. "
+    "Under the guidance of her Christian pastors, she entertained herself, "
+    "besides, with such humane achievements as sentencing a youth to have "
+    "his hands cut off, his tongue torn out with pincers, and his body "
+    "burned alive, because he had not kneeled down in the rain to do "
+    "honour to a dirty procession of monks which passed within his view, "
+    "at a distance of some fifty or sixty yards.";
+
+UTEST(repeat_xor_break, recovers_key)
+{
+	const char key[] = "Terminator X: Bring the noise";
+	const size_t len = sizeof(english_text) - 1;
+	uint8_t *cipher = malloc(len);
+	ASSERT_TRUE(cipher != NULL);
+	ASSERT_EQ(REPEAT_XOR_OK, repeating_key_xor(
+	    (const uint8_t *) english_text, cipher, len,
+	    (const uint8_t *) key, sizeof(key) - 1));
+
+	const size_t thread_counts[] = { 1, 3, 0 };
+	for (size_t t = 0; t < 3; ++t) {
+		repeat_xor_candidate top[3];
+		size_t top_len = 0;
+		ASSERT_EQ(REPEAT_XOR_OK, repeat_xor_break(cipher, len, 2, 40,
+			thread_counts[t], top, 3, &top_len));
+		ASSERT_EQ(3u, top_len);
+		ASSERT_EQ(sizeof(key) - 1, top[0].key_len);
+		ASSERT_EQ(0, memcmp(key, top[0].key, sizeof(key) - 1));
+		ASSERT_TRUE(top[0].distance <= top[1].distance);
+		ASSERT_TRUE(top[1].distance <= top[2].distance);
+	}
+
+	free(cipher);
+}
+
+UTEST(repeat_xor_break, rejects_bad_arguments)
+{
+	const uint8_t cipher[8] = { 0 };
+	repeat_xor_candidate top[1];
+	size_t top_len = 0;
+
+	ASSERT_EQ(REPEAT_XOR_ERR_TOO_SHORT, repeat_xor_break(cipher,
+		sizeof(cipher), 5, 10, 1, top, 1, &top_len));
+	ASSERT_EQ(REPEAT_XOR_ERR_ARGS, repeat_xor_break(cipher,
+		sizeof(cipher), 0, 4, 1, top, 1, &top_len));
+	ASSERT_EQ(REPEAT_XOR_ERR_ARGS, repeat_xor_break(cipher,
+		sizeof(cipher), 1, REPEAT_XOR_MAX_KEY + 1, 1, top, 1,
+		&top_len));
+	ASSERT_EQ(REPEAT_XOR_ERR_ARGS, repeat_xor_break(cipher,
+		sizeof(cipher), 1, 4, 1, top, 0, &top_len));
+	ASSERT_EQ(REPEAT_XOR_OK, repeat_xor_break(cipher, sizeof(cipher), 1,
+		4, 1, top, 1, &top_len));
+	ASSERT_EQ(1u, top_len);
+}
+
+UTEST_MAIN();
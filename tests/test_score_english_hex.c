@@ -3,6 +3,11 @@
  * @brief Unit tests for score_english_hex().
  */
 
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
 #include "score_english_hex.h"
 #include "utest.h"
 
@@ -47,4 +52,210 @@ UTEST(score_english_hex, rejects_null_arguments)
 	ASSERT_EQ(SCORE_ENGLISH_HEX_ERR_ARGS, status);
 }
 
+UTEST(score_english_hex_n, scores_unterminated_view)
+{
+	const char text[] = "48656c6c6f2c20776f726c64ffff";
+	double view_score = 0.0;
+	double full_score = 0.0;
+	ASSERT_EQ(SCORE_ENGLISH_HEX_OK,
+	    score_english_hex_n(text, sizeof(text) - 5, &view_score));
+	ASSERT_EQ(SCORE_ENGLISH_HEX_OK,
+	    score_english_hex("48656c6c6f2c20776f726c64", &full_score));
+	ASSERT_EQ(full_score, view_score);
+
+	ASSERT_EQ(SCORE_ENGLISH_HEX_ERR_EMPTY,
+	    score_english_hex_n(NULL, 0, &view_score));
+	ASSERT_EQ(SCORE_ENGLISH_HEX_ERR_ODD_LENGTH,
+	    score_english_hex_n(text, 3, &view_score));
+}
+
+UTEST(score_english_bytes, matches_hex_scoring)
+{
+	const char english_hex[] = "54686520717569636b2062726f776e20666f7820";
+	const uint8_t english[] = "The quick brown fox ";
+
+	double hex_score = 0.0;
+	double byte_score = 0.0;
+	ASSERT_EQ(SCORE_ENGLISH_HEX_OK,
+	    score_english_hex(english_hex, &hex_score));
+	ASSERT_EQ(SCORE_ENGLISH_HEX_OK,
+	    score_english_bytes(english, sizeof(english) - 1, &byte_score));
+	ASSERT_EQ(hex_score, byte_score);
+}
+
+UTEST(score_english_bytes, long_input_spans_decode_window)
+{
+	char hex[2 * 600 + 1];
+	uint8_t bytes[600];
+	for (size_t i = 0; i < sizeof(bytes); ++i) {
+		bytes[i] = (uint8_t) ("hello world\x01"[i % 12]);
+		snprintf(hex + 2 * i, 3, "%02x", bytes[i]);
+	}
+
+	double hex_score = 0.0;
+	double byte_score = 0.0;
+	ASSERT_EQ(SCORE_ENGLISH_HEX_OK, score_english_hex(hex, &hex_score));
+	ASSERT_EQ(SCORE_ENGLISH_HEX_OK,
+	    score_english_bytes(bytes, sizeof(bytes), &byte_score));
+	ASSERT_EQ(hex_score, byte_score);
+}
+
+UTEST(score_english_hex, rejects_invalid_hex_in_later_window)
+{
+	char hex[2 * 600 + 1];
+	memset(hex, '6', sizeof(hex) - 1);
+	hex[sizeof(hex) - 1] = '\0';
+	hex[2 * 500 + 1] = 'g';
+
+	double score = 0.0;
+	ASSERT_EQ(SCORE_ENGLISH_HEX_ERR_INVALID_HEX,
+	    score_english_hex(hex, &score));
+}
+
+UTEST(score_english_bytes, rejects_empty_and_null)
+{
+	double score = 0.0;
+	const uint8_t byte = 'a';
+	ASSERT_EQ(SCORE_ENGLISH_HEX_ERR_EMPTY,
+	    score_english_bytes(&byte, 0, &score));
+	ASSERT_EQ(SCORE_ENGLISH_HEX_ERR_ARGS,
+	    score_english_bytes(NULL, 1, &score));
+	ASSERT_EQ(SCORE_ENGLISH_HEX_ERR_ARGS,
+	    score_english_bytes(&byte, 1, NULL));
+}
+
+UTEST(score_english_bytes, byte_classes)
+{
+	double upper = 0.0;
+	double lower = 0.0;
+	ASSERT_EQ(SCORE_ENGLISH_HEX_OK,
+	    score_english_bytes((const uint8_t *) "HeLLo", 5, &upper));
+	ASSERT_EQ(SCORE_ENGLISH_HEX_OK,
+	    score_english_bytes((const uint8_t *) "hello", 5, &lower));
+	ASSERT_EQ(lower, upper);
+
+	double score = 0.0;
+	const uint8_t high[] = { 0x80, 0xC9, 0x7F };
+	ASSERT_EQ(SCORE_ENGLISH_HEX_OK,
+	    score_english_bytes(high, sizeof(high), &score));
+	ASSERT_EQ(-1150.0, score);
+
+	const uint8_t neutral[] = { '\t', '\n', '!', '~' };
+	ASSERT_EQ(SCORE_ENGLISH_HEX_OK,
+	    score_english_bytes(neutral, sizeof(neutral), &score));
+	ASSERT_EQ(-1000.0, score);
+}
+
+UTEST(score_english_histogram, matches_hex_scoring)
+{
+	const char english_hex[] = "54686520717569636b2062726f776e20666f7820";
+	const uint8_t english[] = "The quick brown fox ";
+	uint64_t hist[256] = { 0 };
+	for (size_t i = 0; i + 1 < sizeof(english); ++i) {
+		hist[english[i] ^ 0x5A]++;
+	}
+
+	double hex_score = 0.0;
+	double hist_score = 0.0;
+	ASSERT_EQ(SCORE_ENGLISH_HEX_OK,
+	    score_english_hex(english_hex, &hex_score));
+	ASSERT_EQ(SCORE_ENGLISH_HEX_OK,
+	    score_english_histogram(hist, 0x5A, &hist_score));
+	ASSERT_EQ(hex_score, hist_score);
+}
+
+UTEST(score_english_histogram, rejects_empty_histogram)
+{
+	uint64_t hist[256] = { 0 };
+	double score = 0.0;
+	ASSERT_EQ(SCORE_ENGLISH_HEX_ERR_EMPTY,
+	    score_english_histogram(hist, 0, &score));
+	ASSERT_EQ(SCORE_ENGLISH_HEX_ERR_ARGS,
+	    score_english_histogram(NULL, 0, &score));
+}
+
+UTEST(score_english_distinct, matches_histogram_scoring)
+{
+	const uint8_t text[] = "It was the best of times\n\x01";
+	uint64_t hist[256] = { 0 };
+	for (size_t i = 0; i + 1 < sizeof(text); ++i) {
+		hist[text[i] ^ 0x33]++;
+	}
+
+	uint8_t values[256];
+	uint64_t counts[256];
+	size_t n = 0;
+	for (int b = 0; b < 256; ++b) {
+		if (hist[b] != 0) {
+			values[n] = (uint8_t) b;
+			counts[n++] = hist[b];
+		}
+	}
+
+	for (int key = 0; key < 256; ++key) {
+		double hist_score = 0.0;
+		double distinct_score = 0.0;
+		ASSERT_EQ(SCORE_ENGLISH_HEX_OK, score_english_histogram(hist,
+			(uint8_t) key, &hist_score));
+		ASSERT_EQ(SCORE_ENGLISH_HEX_OK, score_english_distinct(values,
+			counts, n, (uint8_t) key, &distinct_score));
+		ASSERT_EQ(hist_score, distinct_score);
+	}
+
+	double score = 0.0;
+	ASSERT_EQ(SCORE_ENGLISH_HEX_ERR_EMPTY,
+	    score_english_distinct(NULL, NULL, 0, 0, &score));
+	ASSERT_EQ(SCORE_ENGLISH_HEX_ERR_ARGS,
+	    score_english_distinct(NULL, counts, 1, 0, &score));
+}
+
+UTEST(score_english_distinct_bounded, matches_full_score_or_bound)
+{
+	// Commonest first: space, e, t, ...
+	const uint8_t values[] = { ' ', 'e', 't', 'a', 'o', 'n', '.', 'z' };
+	const uint64_t counts[] = { 900, 600, 450, 400, 380, 300, 40, 3 };
+	const size_t n = sizeof(values);
+
+	for (int key = 0; key < 256; ++key) {
+		double full = 0.0;
+		ASSERT_EQ(SCORE_ENGLISH_HEX_OK, score_english_distinct(values,
+			counts, n, (uint8_t) key, &full));
+
+		double score = 0.0;
+		size_t examined = 0;
+		ASSERT_EQ(SCORE_ENGLISH_HEX_OK,
+		    score_english_distinct_bounded(values, counts, n,
+			(uint8_t) key, -HUGE_VAL, &score, &examined));
+		ASSERT_EQ(full, score);
+		ASSERT_EQ(n, examined);
+
+		// Against a bar only English clears, a pruned key reports a
+		// bound that is below the bar and still above its real score.
+		score_english_hex_status status =
+		    score_english_distinct_bounded(values, counts, n,
+		    (uint8_t) key, 0.0, &score, &examined);
+		if (status == SCORE_ENGLISH_HEX_PRUNED) {
+			ASSERT_LT(score, 0.0);
+			ASSERT_GE(score, full);
+			ASSERT_LT(examined, n);
+		} else {
+			ASSERT_EQ(SCORE_ENGLISH_HEX_OK, status);
+			ASSERT_EQ(full, score);
+		}
+	}
+
+	// Key 0x80 makes every byte non-ASCII: rejected on the first entry.
+	double score = 0.0;
+	size_t examined = 0;
+	ASSERT_EQ(SCORE_ENGLISH_HEX_PRUNED, score_english_distinct_bounded(values,
+		counts, n, 0x80, 0.0, &score, &examined));
+	ASSERT_EQ((size_t) 1, examined);
+	ASSERT_EQ(SCORE_ENGLISH_HEX_ERR_EMPTY,
+	    score_english_distinct_bounded(NULL, NULL, 0, 0, 0.0, &score,
+		NULL));
+	ASSERT_EQ(SCORE_ENGLISH_HEX_ERR_ARGS,
+	    score_english_distinct_bounded(NULL, counts, 1, 0, 0.0, &score,
+		NULL));
+}
+
 UTEST_MAIN();
@@ -0,0 +1,82 @@
+/**
+ * @file test_stats.c
+ * @brief Unit tests for the instrumentation counters.
+ *
+ * Built either way: with CRYPTOPALS_STATS the counters must track calls
+ * from every thread, without it they must stay at zero.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fixed_xor.h"
+#include "stats.h"
+#include "utils.h"
+#include "utest.h"
+
+static void *
+decode_in_thread(void *arg)
+{
+	uint8_t out[4];
+	(void) arg;
+	hex_to_bytes_n("deadbeef", 8, out, sizeof(out), NULL);
+	return NULL;
+}
+
+UTEST(stats, counts_calls_across_threads)
+{
+	stats_counter before[STATS_COUNT];
+	stats_counter after[STATS_COUNT];
+	stats_snapshot(before);
+
+	uint8_t out[4];
+	ASSERT_EQ(UTILS_OK, hex_to_bytes_n("00112233", 8, out, sizeof(out),
+		NULL));
+	pthread_t tid;
+	ASSERT_EQ(0, pthread_create(&tid, NULL, decode_in_thread, NULL));
+	ASSERT_EQ(0, pthread_join(tid, NULL));
+	// Failed calls count too.
+	ASSERT_EQ(FIXED_XOR_ERR_ARGS, fixed_xor_buffers(NULL, out, out, 4));
+
+	stats_snapshot(after);
+#ifdef CRYPTOPALS_STATS
+	ASSERT_EQ(before[STATS_HEX_DECODE].calls + 2,
+	    after[STATS_HEX_DECODE].calls);
+	ASSERT_EQ(before[STATS_HEX_DECODE].bytes + 16,
+	    after[STATS_HEX_DECODE].bytes);
+	ASSERT_EQ(before[STATS_FIXED_XOR].calls + 1,
+	    after[STATS_FIXED_XOR].calls);
+#else
+	for (int i = 0; i < STATS_COUNT; ++i) {
+		ASSERT_EQ((uint64_t) 0, after[i].calls);
+		ASSERT_EQ((uint64_t) 0, after[i].ns);
+	}
+#endif
+}
+
+UTEST(stats, dump_lists_called_primitives)
+{
+	uint8_t bytes[3] = { 1, 2, 3 };
+	char hex[7];
+	ASSERT_EQ(UTILS_OK, bytes_to_hex(bytes, 3, hex, sizeof(hex)));
+
+	char text[2048] = { 0 };
+	FILE *out = fmemopen(text, sizeof(text) - 1, "w");
+	ASSERT_TRUE(out != NULL);
+	stats_dump(out);
+	fclose(out);
+
+#ifdef CRYPTOPALS_STATS
+	ASSERT_TRUE(strstr(text, "hex_encode") != NULL);
+	ASSERT_TRUE(strstr(text, "aes") == NULL);
+#else
+	ASSERT_STREQ("", text);
+#endif
+	ASSERT_STREQ("single_byte_xor",
+	    stats_primitive_name(STATS_SINGLE_BYTE_XOR));
+	ASSERT_STREQ("unknown", stats_primitive_name(STATS_COUNT));
+}
+
+UTEST_MAIN();
@@ -6,7 +6,9 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "cpu_features.h"
 #include "fixed_xor.h"
+#include "score_english_hex.h"
 #include "utils.h"
 #include "utest.h"
 
@@ -68,6 +70,65 @@ UTEST(hex_to_bytes, rejects_null_buffer)
 	ASSERT_EQ(UTILS_ERR_ARGS, status);
 }
 
+UTEST(hex_to_bytes_n, decodes_unterminated_view)
+{
+	const char text[] = "deadbeefXX";
+	uint8_t out[4];
+	size_t len = 0;
+	ASSERT_EQ(UTILS_OK, hex_to_bytes_n(text, 8, out, sizeof(out), &len));
+	ASSERT_EQ(4u, len);
+	EXPECT_EQ(0xEF, out[3]);
+	ASSERT_EQ(UTILS_ERR_INVALID_HEX,
+	    hex_to_bytes_n(text, 10, out, 5, &len));
+	ASSERT_EQ(UTILS_ERR_ARGS, hex_to_bytes_n(NULL, 2, out, 1, &len));
+}
+
+UTEST(hex_to_bytes, simd_matches_scalar_fuzz)
+{
+	static const char valid[] = "0123456789abcdefABCDEF";
+	static const char invalid[] = { '/', ':', '@', 'G', '`', 'g', ' ',
+		'\0', (char) 0x80, (char) 0xB0, (char) 0xE6, (char) 0xFF };
+	const unsigned masks[] = { CPU_FEATURE_SSE2, ~0u };
+	char hex[260];
+	uint8_t scalar_out[130];
+	uint8_t simd_out[130];
+	uint32_t state = 0xC0FFEEu;
+
+	for (int round = 0; round < 20000; ++round) {
+		state = state * 1103515245u + 12345u;
+		size_t hex_len = (state >> 8) % sizeof(hex);
+		for (size_t i = 0; i < hex_len; ++i) {
+			state = state * 1103515245u + 12345u;
+			hex[i] = valid[(state >> 16) % (sizeof(valid) - 1)];
+		}
+		// Roughly one input in four carries a single bad character.
+		state = state * 1103515245u + 12345u;
+		if (hex_len > 0 && (state >> 28) < 4) {
+			size_t at = (state >> 4) % hex_len;
+			hex[at] = invalid[(state >> 20) % sizeof(invalid)];
+		}
+
+		cpu_features_set_mask(0);
+		size_t scalar_len = 0;
+		utils_status scalar_status = hex_to_bytes_n(hex, hex_len,
+		    scalar_out, sizeof(scalar_out), &scalar_len);
+
+		for (size_t m = 0; m < sizeof(masks) / sizeof(masks[0]); ++m) {
+			cpu_features_set_mask(masks[m]);
+			size_t simd_len = 0;
+			utils_status simd_status = hex_to_bytes_n(hex, hex_len,
+			    simd_out, sizeof(simd_out), &simd_len);
+			ASSERT_EQ(scalar_status, simd_status);
+			if (scalar_status == UTILS_OK) {
+				ASSERT_EQ(scalar_len, simd_len);
+				ASSERT_EQ(0, memcmp(scalar_out, simd_out,
+					scalar_len));
+			}
+		}
+	}
+	cpu_features_set_mask(~0u);
+}
+
 UTEST(bytes_to_hex, round_trip)
 {
 	const uint8_t bytes[] = { 0x41, 0x42, 0x43 };
@@ -78,6 +139,34 @@ UTEST(bytes_to_hex, round_trip)
 	ASSERT_STREQ("414243", hex);
 }
 
+UTEST(bytes_to_hex, simd_matches_scalar)
+{
+	const unsigned masks[] = { CPU_FEATURE_SSSE3, ~0u };
+	uint8_t bytes[200];
+	char scalar_hex[401];
+	char simd_hex[401];
+	uint32_t state = 7u;
+
+	for (size_t i = 0; i < sizeof(bytes); ++i) {
+		state = state * 1103515245u + 12345u;
+		bytes[i] = (uint8_t) (state >> 24);
+	}
+
+	for (size_t len = 0; len <= sizeof(bytes); ++len) {
+		cpu_features_set_mask(0);
+		ASSERT_EQ(UTILS_OK, bytes_to_hex(bytes + sizeof(bytes) - len,
+			len, scalar_hex, sizeof(scalar_hex)));
+		for (size_t m = 0; m < sizeof(masks) / sizeof(masks[0]); ++m) {
+			cpu_features_set_mask(masks[m]);
+			ASSERT_EQ(UTILS_OK, bytes_to_hex(bytes +
+				sizeof(bytes) - len, len, simd_hex,
+				sizeof(simd_hex)));
+			ASSERT_STREQ(scalar_hex, simd_hex);
+		}
+	}
+	cpu_features_set_mask(~0u);
+}
+
 UTEST(bytes_to_hex, buffer_too_small)
 {
 	const uint8_t bytes[] = { 0x41 };
@@ -102,6 +191,24 @@ UTEST(hex_to_ascii, truncates_when_short)
 	ASSERT_EQ(UTILS_ERR_BUFFER_TOO_SMALL, status);
 }
 
+UTEST(hex_to_ascii_n, decodes_unterminated_view)
+{
+	const char text[] = "41424344zz";
+	char out[8];
+	ASSERT_EQ(UTILS_OK, hex_to_ascii_n(text, 6, out, sizeof(out)));
+	ASSERT_STREQ("ABC", out);
+
+	// Matches hex_to_ascii(): a trailing odd digit is dropped.
+	ASSERT_EQ(UTILS_OK, hex_to_ascii_n(text, 7, out, sizeof(out)));
+	ASSERT_STREQ("ABC", out);
+
+	ASSERT_EQ(UTILS_ERR_INVALID_HEX, hex_to_ascii_n(text, 10, out,
+		sizeof(out)));
+	ASSERT_EQ(UTILS_ERR_BUFFER_TOO_SMALL, hex_to_ascii_n(text, 8, out, 4));
+	ASSERT_EQ(UTILS_OK, hex_to_ascii_n(NULL, 0, out, 1));
+	ASSERT_STREQ("", out);
+}
+
 UTEST(brute_force_single_byte_xor, decodes_known_cipher)
 {
 	const char hex[] =
@@ -125,6 +232,21 @@ UTEST(brute_force_single_byte_xor, decodes_known_cipher)
 	ASSERT_STREQ("Cooking MC's like a pound of bacon", ascii);
 }
 
+UTEST(brute_force_single_byte_xor_n, decodes_unterminated_view)
+{
+	const char hex[] =
+	    "1b37373331363f78151b7f2b783431333d78397828372d363c78373e783a393b3736"
+	    "ffff";
+	uint8_t plain[64];
+	size_t len = 0;
+	uint8_t key = 0;
+	ASSERT_EQ(UTILS_OK, brute_force_single_byte_xor_n(hex,
+		sizeof(hex) - 5, plain, sizeof(plain), &len, &key, NULL));
+	ASSERT_EQ(34u, len);
+	ASSERT_EQ(0x58, key);
+	ASSERT_EQ(0, memcmp("Cooking MC's like a pound of bacon", plain, len));
+}
+
 UTEST(brute_force_single_byte_xor, invalid_hex_input)
 {
 	uint8_t plain[8];
@@ -158,6 +280,237 @@ UTEST(brute_force_single_byte_xor, insufficient_output_buffer)
 	ASSERT_EQ(UTILS_ERR_BUFFER_TOO_SMALL, status);
 }
 
+/*
+ * Reference brute force: XOR every key, hex-encode and score the candidate.
+ */
+static void
+reference_single_byte_xor(const uint8_t *cipher, size_t len,
+    uint8_t *best_key, double *best_score)
+{
+	uint8_t candidate[256];
+	char candidate_hex[513];
+
+	*best_score = -1e12;
+	*best_key = 0;
+	for (int key = 0; key <= 0xFF; ++key) {
+		for (size_t i = 0; i < len; ++i) {
+			candidate[i] = cipher[i] ^ (uint8_t) key;
+		}
+		bytes_to_hex(candidate, len, candidate_hex,
+		    sizeof(candidate_hex));
+		double score = 0.0;
+		score_english_hex(candidate_hex, &score);
+		if (score > *best_score) {
+			*best_score = score;
+			*best_key = (uint8_t) key;
+		}
+	}
+}
+
+UTEST(brute_force_single_byte_xor, histogram_matches_reference)
+{
+	uint8_t cipher[256];
+	char hex[513];
+	uint32_t state = 12345u;
+
+	for (size_t round = 0; round < 64; ++round) {
+		size_t len = 1 + (round * 37) % sizeof(cipher);
+		for (size_t i = 0; i < len; ++i) {
+			state = state * 1103515245u + 12345u;
+			// Alternate between random bytes and XORed English-ish text.
+			uint8_t plain = (round & 1) ? (uint8_t) (state >> 24) :
+			    (uint8_t) ("etaoin shrdlu, THE cat.\n"[(state >> 16) % 24]);
+			cipher[i] = plain ^ (uint8_t) (round * 7);
+		}
+		ASSERT_EQ(UTILS_OK, bytes_to_hex(cipher, len, hex, sizeof(hex)));
+
+		uint8_t ref_key = 0;
+		double ref_score = 0.0;
+		reference_single_byte_xor(cipher, len, &ref_key, &ref_score);
+
+		uint8_t plain[256];
+		size_t plain_len = 0;
+		uint8_t key = 0;
+		double score = 0.0;
+		ASSERT_EQ(UTILS_OK, brute_force_single_byte_xor(hex, plain,
+			sizeof(plain), &plain_len, &key, &score));
+		ASSERT_EQ(len, plain_len);
+		ASSERT_EQ(ref_key, key);
+		ASSERT_EQ(ref_score, score);
+		for (size_t i = 0; i < len; ++i) {
+			ASSERT_EQ((uint8_t) (cipher[i] ^ key), plain[i]);
+		}
+	}
+}
+
+UTEST(brute_force_single_byte_xor_batch, matches_single_calls)
+{
+	static const char *const lines[] = {
+		"1b37373331363f78151b7f2b783431333d78397828372d363c78373e783a393b3736",
+		"0e3647e8592d35514a081243582536ed3de6734059001e3f535ce6271032",
+		"zz11",
+		"",
+		"abc",
+		"7b5a4215415d544115415d5015455447414c155c46155f4058455c5b523f",
+	};
+	const size_t count = sizeof(lines) / sizeof(lines[0]);
+	utils_hex_view views[6];
+	size_t need = 0;
+	for (size_t i = 0; i < count; ++i) {
+		views[i].hex = lines[i];
+		views[i].len = strlen(lines[i]);
+		need += views[i].len / 2;
+	}
+
+	uint8_t arena[128];
+	utils_xor_result results[6];
+	ASSERT_EQ(UTILS_ERR_BUFFER_TOO_SMALL,
+	    brute_force_single_byte_xor_batch(views, count, arena, need - 1,
+		results));
+	ASSERT_EQ(UTILS_OK, brute_force_single_byte_xor_batch(views, count,
+		arena, sizeof(arena), results));
+
+	size_t offset = 0;
+	for (size_t i = 0; i < count; ++i) {
+		ASSERT_EQ(offset, results[i].plain_offset);
+		offset += views[i].len / 2;
+
+		uint8_t plain[64];
+		size_t len = 0;
+		uint8_t key = 0;
+		double score = 0.0;
+		utils_status status = views[i].len == 0 ? UTILS_ERR_ARGS :
+		    brute_force_single_byte_xor(lines[i], plain, sizeof(plain),
+		    &len, &key, &score);
+		ASSERT_EQ(status, results[i].status);
+		if (status != UTILS_OK) {
+			ASSERT_EQ((size_t) 0, results[i].plain_len);
+			continue;
+		}
+		ASSERT_EQ(len, results[i].plain_len);
+		ASSERT_EQ(key, results[i].key);
+		ASSERT_EQ(score, results[i].score);
+		ASSERT_EQ(0, memcmp(plain, arena + results[i].plain_offset,
+			len));
+	}
+	ASSERT_EQ(0, memcmp("Cooking MC's like a pound of bacon", arena, 34));
+	ASSERT_EQ(UTILS_ERR_INVALID_HEX, results[2].status);
+	ASSERT_EQ(UTILS_ERR_ODD_LENGTH, results[4].status);
+
+	ASSERT_EQ(UTILS_OK, brute_force_single_byte_xor_batch(NULL, 0, NULL,
+		0, NULL));
+}
+
+UTEST(brute_force_single_byte_xor_top_k, matches_exhaustive_ranking)
+{
+	uint8_t cipher[256];
+	uint32_t state = 777u;
+
+	for (size_t round = 0; round < 32; ++round) {
+		size_t len = 1 + (round * 53) % sizeof(cipher);
+		for (size_t i = 0; i < len; ++i) {
+			state = state * 1103515245u + 12345u;
+			uint8_t plain = (round & 1) ? (uint8_t) (state >> 24) :
+			    (uint8_t) ("etaoin shrdlu, THE cat.\n"[(state >> 16) % 24]);
+			cipher[i] = plain ^ (uint8_t) (round * 11);
+		}
+
+		// Exhaustive ranking by repeated selection from histogram scores.
+		uint64_t hist[256];
+		ASSERT_EQ(UTILS_OK, utils_byte_histogram(cipher, len, hist));
+		utils_key_score all[256];
+		for (int key = 0; key < 256; ++key) {
+			all[key].key = (uint8_t) key;
+			ASSERT_EQ(SCORE_ENGLISH_HEX_OK, score_english_histogram(hist,
+				(uint8_t) key, &all[key].score));
+		}
+		for (size_t i = 0; i < 256; ++i) {
+			size_t best = i;
+			for (size_t j = i + 1; j < 256; ++j) {
+				if (all[j].score > all[best].score) {
+					best = j;
+				}
+			}
+			// Shift rather than swap so equal scores keep key order.
+			utils_key_score pick = all[best];
+			memmove(&all[i + 1], &all[i], (best - i) * sizeof(all[0]));
+			all[i] = pick;
+		}
+
+		static const size_t ks[] = { 1, 3, 10, 300 };
+		for (size_t t = 0; t < sizeof(ks) / sizeof(ks[0]); ++t) {
+			utils_key_score top[256];
+			size_t count = 0;
+			ASSERT_EQ(UTILS_OK, brute_force_single_byte_xor_top_k(hist,
+				ks[t], top, &count, NULL));
+			ASSERT_EQ(ks[t] > 256 ? (size_t) 256 : ks[t], count);
+			for (size_t i = 0; i < count; ++i) {
+				ASSERT_EQ(all[i].key, top[i].key);
+				ASSERT_EQ(all[i].score, top[i].score);
+			}
+		}
+
+		uint8_t best_key = 0;
+		double best_score = 0.0;
+		ASSERT_EQ(UTILS_OK, brute_force_single_byte_xor_histogram(hist,
+			&best_key, &best_score));
+		ASSERT_EQ(best_key, all[0].key);
+	}
+}
+
+UTEST(brute_force_single_byte_xor_top_k, prunes_long_ciphertexts)
+{
+	static uint8_t cipher[1 << 16];
+	const char *text = "Now that the party is jumping, with the bass kicked "
+	    "in and the Vegas are pumping.\n";
+	size_t text_len = strlen(text);
+	for (size_t i = 0; i < sizeof(cipher); ++i) {
+		cipher[i] = (uint8_t) text[i % text_len] ^ 0x58;
+	}
+
+	uint64_t hist[256];
+	ASSERT_EQ(UTILS_OK, utils_byte_histogram(cipher, sizeof(cipher), hist));
+	size_t distinct = 0;
+	for (int b = 0; b < 256; ++b) {
+		distinct += hist[b] != 0;
+	}
+
+	utils_key_score top[5];
+	size_t count = 0;
+	size_t examined = 0;
+	ASSERT_EQ(UTILS_OK, brute_force_single_byte_xor_top_k(hist, 5, top,
+		&count, &examined));
+	ASSERT_EQ((size_t) 5, count);
+	ASSERT_EQ(0x58, top[0].key);
+	for (size_t i = 1; i < count; ++i) {
+		ASSERT_GE(top[i - 1].score, top[i].score);
+	}
+	// Most keys are rejected on the commonest few bytes instead of
+	// being scored over every distinct value.
+	ASSERT_LT(examined, 256 * distinct / 3);
+
+	uint64_t empty[256] = { 0 };
+	ASSERT_EQ(UTILS_ERR_ARGS, brute_force_single_byte_xor_top_k(empty, 5,
+		top, &count, NULL));
+	ASSERT_EQ(UTILS_ERR_ARGS, brute_force_single_byte_xor_top_k(hist, 0,
+		top, &count, NULL));
+	ASSERT_EQ(UTILS_ERR_ARGS, brute_force_single_byte_xor_top_k(NULL, 5,
+		top, &count, NULL));
+}
+
+UTEST(utils_byte_histogram, counts_bytes)
+{
+	const uint8_t bytes[] = { 'a', 'b', 'a', 0x00, 0xFF, 'a', 0xFF };
+	uint64_t hist[256];
+	ASSERT_EQ(UTILS_OK, utils_byte_histogram(bytes, sizeof(bytes), hist));
+	EXPECT_EQ(3u, hist['a']);
+	EXPECT_EQ(1u, hist['b']);
+	EXPECT_EQ(1u, hist[0x00]);
+	EXPECT_EQ(2u, hist[0xFF]);
+	EXPECT_EQ(0u, hist['c']);
+	ASSERT_EQ(UTILS_ERR_ARGS, utils_byte_histogram(bytes, 1, NULL));
+}
+
 UTEST(utils_repeat_key, fills_buffer)
 {
 	const char key[] = "ICE";
@@ -184,6 +537,17 @@ UTEST(utils_repeat_key, rejects_empty_key)
 	ASSERT_EQ(UTILS_ERR_ARGS, status);
 }
 
+UTEST(utils_repeat_key_n, keeps_embedded_nul)
+{
+	const char key[] = { 'a', '\0', 'b' };
+	uint8_t out[7];
+	ASSERT_EQ(UTILS_OK, utils_repeat_key_n(key, sizeof(key), out,
+		sizeof(out)));
+	const uint8_t expected[] = { 'a', 0, 'b', 'a', 0, 'b', 'a' };
+	ASSERT_EQ(0, memcmp(expected, out, sizeof(out)));
+	ASSERT_EQ(UTILS_ERR_ARGS, utils_repeat_key_n(key, 0, out, 1));
+}
+
 UTEST(utils_repeat_key, encrypts_expected_cipher)
 {
 	const char plaintext[] =
@@ -222,6 +586,64 @@ UTEST(utils_repeat_key, encrypts_expected_cipher)
 	free(cipher_hex);
 }
 
+UTEST(utils_transpose_columns, matches_strided_gather)
+{
+	enum
+	{ MAX_LEN = 50000 };
+	static uint8_t in[MAX_LEN];
+	static uint8_t out[MAX_LEN];
+	static uint64_t hist[41 * 256];
+	for (size_t i = 0; i < MAX_LEN; ++i) {
+		in[i] = (uint8_t) (i * 7u + (i >> 9));
+	}
+
+	const size_t lens[] = { 0, 1, 5, 40, 41, 1000, MAX_LEN };
+	const size_t columns[] = { 1, 2, 3, 29, 41 };
+	for (size_t l = 0; l < sizeof(lens) / sizeof(lens[0]); ++l) {
+		for (size_t k = 0; k < sizeof(columns) / sizeof(columns[0]);
+		    ++k) {
+			size_t len = lens[l];
+			size_t cols = columns[k];
+			ASSERT_EQ(UTILS_OK, utils_transpose_columns(in, len,
+				cols, out, sizeof(out), hist));
+
+			size_t pos = 0;
+			for (size_t c = 0; c < cols; ++c) {
+				uint64_t want[256] = { 0 };
+				for (size_t i = c; i < len; i += cols) {
+					ASSERT_EQ(in[i], out[pos]);
+					pos++;
+					want[in[i]]++;
+				}
+				ASSERT_EQ(0, memcmp(want, hist + c * 256,
+					sizeof(want)));
+			}
+			ASSERT_EQ(len, pos);
+		}
+	}
+
+	// Histograms alone, without a column arena.
+	static uint64_t only[29 * 256];
+	ASSERT_EQ(UTILS_OK, utils_transpose_columns(in, MAX_LEN, 29, NULL, 0,
+		only));
+	ASSERT_EQ(UTILS_OK, utils_transpose_columns(in, MAX_LEN, 29, out,
+		sizeof(out), hist));
+	ASSERT_EQ(0, memcmp(only, hist, sizeof(only)));
+}
+
+UTEST(utils_transpose_columns, rejects_bad_arguments)
+{
+	uint8_t in[8] = { 0 };
+	uint8_t out[8];
+
+	ASSERT_EQ(UTILS_ERR_ARGS, utils_transpose_columns(in, sizeof(in), 0,
+		out, sizeof(out), NULL));
+	ASSERT_EQ(UTILS_ERR_ARGS, utils_transpose_columns(NULL, 1, 1, out,
+		sizeof(out), NULL));
+	ASSERT_EQ(UTILS_ERR_BUFFER_TOO_SMALL, utils_transpose_columns(in,
+		sizeof(in), 2, out, 4, NULL));
+}
+
 UTEST(utils_status_string, returns_messages)
 {
 	ASSERT_STREQ("success", utils_status_string(UTILS_OK));
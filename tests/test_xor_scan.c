@@ -0,0 +1,170 @@
+/**
+ * @file test_xor_scan.c
+ * @brief Unit tests for the parallel single-byte XOR line scanner.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils.h"
+#include "xor_scan.h"
+#include "utest.h"
+
+#define CORPUS_LINES 200
+
+/*
+ * Build a corpus of random 30-byte lines with one English plaintext hidden
+ * at line @p target under key 0x35.
+ */
+static char **
+make_corpus(size_t target)
+{
+	static const char secret[] = "Now that the party is jumping\n";
+	char **lines = calloc(CORPUS_LINES, sizeof(char *));
+	uint32_t state = 42u;
+
+	for (size_t i = 0; lines && i < CORPUS_LINES; ++i) {
+		uint8_t bytes[30];
+		for (size_t j = 0; j < sizeof(bytes); ++j) {
+			state = state * 1103515245u + 12345u;
+			bytes[j] = (i == target) ?
+			    (uint8_t) (secret[j] ^ 0x35) : (uint8_t) (state >> 24);
+		}
+		lines[i] = malloc(2 * sizeof(bytes) + 1);
+		bytes_to_hex(bytes, sizeof(bytes), lines[i],
+		    2 * sizeof(bytes) + 1);
+	}
+	return lines;
+}
+
+static void
+free_corpus(char **lines)
+{
+	for (size_t i = 0; i < CORPUS_LINES; ++i) {
+		free(lines[i]);
+	}
+	free(lines);
+}
+
+UTEST(xor_scan_lines, finds_hidden_line)
+{
+	char **lines = make_corpus(123);
+	ASSERT_TRUE(lines != NULL);
+
+	xor_scan_result top[1];
+	size_t top_len = 0;
+	size_t skipped = 99;
+	ASSERT_EQ(XOR_SCAN_OK, xor_scan_lines((const char *const *) lines,
+		CORPUS_LINES, 4, top, 1, &top_len, &skipped));
+	ASSERT_EQ(1u, top_len);
+	ASSERT_EQ(0u, skipped);
+	ASSERT_EQ(123u, top[0].line);
+	ASSERT_EQ(0x35, top[0].key);
+
+	free_corpus(lines);
+}
+
+UTEST(xor_scan_lines, top_n_independent_of_thread_count)
+{
+	char **lines = make_corpus(7);
+	ASSERT_TRUE(lines != NULL);
+
+	xor_scan_result serial[16];
+	xor_scan_result parallel[16];
+	size_t serial_len = 0;
+	size_t parallel_len = 0;
+	ASSERT_EQ(XOR_SCAN_OK, xor_scan_lines((const char *const *) lines,
+		CORPUS_LINES, 1, serial, 16, &serial_len, NULL));
+	ASSERT_EQ(XOR_SCAN_OK, xor_scan_lines((const char *const *) lines,
+		CORPUS_LINES, 7, parallel, 16, &parallel_len, NULL));
+	ASSERT_EQ(16u, serial_len);
+	ASSERT_EQ(serial_len, parallel_len);
+
+	for (size_t i = 0; i < serial_len; ++i) {
+		ASSERT_EQ(serial[i].line, parallel[i].line);
+		ASSERT_EQ(serial[i].key, parallel[i].key);
+		ASSERT_EQ(serial[i].score, parallel[i].score);
+		if (i > 0) {
+			ASSERT_GE(serial[i - 1].score, serial[i].score);
+		}
+	}
+	ASSERT_EQ(7u, serial[0].line);
+
+	free_corpus(lines);
+}
+
+UTEST(xor_scan_corpus, matches_line_scan)
+{
+	char **lines = make_corpus(150);
+	ASSERT_TRUE(lines != NULL);
+
+	// Join the lines with a mix of terminators and blank lines.
+	char *text = malloc(CORPUS_LINES * 64 + 16);
+	ASSERT_TRUE(text != NULL);
+	size_t len = 0;
+	for (size_t i = 0; i < CORPUS_LINES; ++i) {
+		len += (size_t) sprintf(text + len, "%s%s", lines[i],
+		    (i % 3 == 0) ? "\r\n" : (i % 5 == 0) ? "\n\n" : "\n");
+	}
+
+	hex_corpus corpus;
+	ASSERT_EQ(HEX_CORPUS_OK, hex_corpus_from_buffer(text, len, &corpus));
+
+	xor_scan_result expected[8];
+	xor_scan_result actual[8];
+	size_t expected_len = 0;
+	size_t actual_len = 0;
+	ASSERT_EQ(XOR_SCAN_OK, xor_scan_lines((const char *const *) lines,
+		CORPUS_LINES, 1, expected, 8, &expected_len, NULL));
+	ASSERT_EQ(XOR_SCAN_OK, xor_scan_corpus(&corpus, 5, actual, 8,
+		&actual_len, NULL));
+	ASSERT_EQ(expected_len, actual_len);
+	for (size_t i = 0; i < actual_len; ++i) {
+		ASSERT_EQ(expected[i].line, actual[i].line);
+		ASSERT_EQ(expected[i].key, actual[i].key);
+		ASSERT_EQ(expected[i].score, actual[i].score);
+		ASSERT_EQ(60u, actual[i].hex_len);
+		ASSERT_EQ(0, memcmp(lines[actual[i].line], actual[i].hex, 60));
+	}
+	ASSERT_EQ(150u, actual[0].line);
+
+	free(text);
+	free_corpus(lines);
+}
+
+UTEST(xor_scan_lines, skips_invalid_lines)
+{
+	const char *lines[] = { "zz", "", "1b37373331363f78151b7f2b7834", "abc" };
+	xor_scan_result top[4];
+	size_t top_len = 0;
+	size_t skipped = 0;
+	ASSERT_EQ(XOR_SCAN_OK, xor_scan_lines(lines, 4, 0, top, 4, &top_len,
+		&skipped));
+	ASSERT_EQ(1u, top_len);
+	ASSERT_EQ(3u, skipped);
+	ASSERT_EQ(2u, top[0].line);
+	ASSERT_EQ(0x58, top[0].key);
+}
+
+UTEST(xor_scan_lines, rejects_bad_arguments)
+{
+	const char *lines[] = { "00" };
+	xor_scan_result top[1];
+	size_t top_len = 0;
+	ASSERT_EQ(XOR_SCAN_ERR_ARGS, xor_scan_lines(NULL, 1, 1, top, 1,
+		&top_len, NULL));
+	ASSERT_EQ(XOR_SCAN_ERR_ARGS, xor_scan_lines(lines, 1, 1, top, 0,
+		&top_len, NULL));
+	ASSERT_EQ(XOR_SCAN_ERR_ARGS, xor_scan_lines(lines, 1, 1, NULL, 1,
+		&top_len, NULL));
+}
+
+UTEST(xor_scan_status_string, returns_messages)
+{
+	ASSERT_STREQ("success", xor_scan_status_string(XOR_SCAN_OK));
+	ASSERT_STREQ("out of memory", xor_scan_status_string(XOR_SCAN_ERR_OOM));
+}
+
+UTEST_MAIN();
@@ -5,18 +5,68 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "fixed_xor.h"
+#include "stats.h"
 
 /**
- * @brief Entry point that streams stdin through fixed_xor_stream().
+ * @brief Open @p path for reading, treating "-" as stdin.
+ */
+static FILE *
+open_input(const char *path)
+{
+	if (strcmp(path, "-") == 0) {
+		return stdin;
+	}
+	FILE *fp = fopen(path, "rb");
+	if (!fp) {
+		perror(path);
+	}
+	return fp;
+}
+
+/**
+ * @brief Entry point.
+ *
+ * With no arguments stdin holds both buffers back to back and is split in
+ * half by fixed_xor_stream(). With two paths the files are XORed against
+ * each other block by block by fixed_xor_stream_pair().
  *
  * @return EXIT_SUCCESS on success, EXIT_FAILURE otherwise.
  */
 int
-main(void)
+main(int argc, char **argv)
 {
-	fixed_xor_status status = fixed_xor_stream(stdin, stdout);
+	fixed_xor_status status;
+
+	stats_dump_at_exit();
+	if (argc == 1) {
+		status = fixed_xor_stream(stdin, stdout);
+	} else if (argc == 3) {
+		FILE *lhs = open_input(argv[1]);
+		FILE *rhs = lhs ? open_input(argv[2]) : NULL;
+		if (!lhs || !rhs) {
+			if (lhs && lhs != stdin) {
+				fclose(lhs);
+			}
+			return EXIT_FAILURE;
+		}
+		status = fixed_xor_stream_pair(lhs, rhs, stdout);
+		if (lhs != stdin) {
+			fclose(lhs);
+		}
+		if (rhs != stdin) {
+			fclose(rhs);
+		}
+	} else {
+		fprintf(stderr, "usage: fixed_xor [LHS_FILE RHS_FILE]\n");
+		return EXIT_FAILURE;
+	}
+
+	if (status == FIXED_XOR_OK && fflush(stdout) != 0) {
+		status = FIXED_XOR_ERR_IO;
+	}
 	if (status != FIXED_XOR_OK) {
 		fprintf(stderr, "fixed_xor: %s\n",
 		    fixed_xor_status_string(status));
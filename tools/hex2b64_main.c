@@ -7,10 +7,12 @@
 #include <stdlib.h>
 
 #include "hex2b64.h"
+#include "stats.h"
 
 int
 main(void)
 {
+	stats_dump_at_exit();
 	hex2b64_status status = hex2b64_stream(stdin, stdout);
 	if (status != HEX2B64_OK) {
 		fprintf(stderr, "hex2b64: %s\n",
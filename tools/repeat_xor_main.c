@@ -0,0 +1,119 @@
+/**
+ * @file repeat_xor_main.c
+ * @brief Command-line tool that streams stdin through repeating-key XOR.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hex2b64.h"
+#include "repeat_xor.h"
+#include "stats.h"
+#include "utils.h"
+
+/**
+ * @brief Bytes read per step. A multiple of 3, so only the final chunk can
+ * produce Base64 padding.
+ */
+#define REPEAT_XOR_CHUNK (3 * 16384)
+
+typedef enum
+{
+	OUTPUT_RAW,
+	OUTPUT_HEX,
+	OUTPUT_BASE64
+} output_format;
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: repeat_xor [-x | -b] KEY\n"
+	    "  -x  write hex instead of raw bytes\n"
+	    "  -b  write Base64 instead of raw bytes\n");
+}
+
+/**
+ * @brief Write @p len XORed bytes to stdout in the requested format.
+ *
+ * @return Non-zero on success.
+ */
+static int
+write_chunk(output_format format, const uint8_t *bytes, size_t len)
+{
+	static char text[2 * REPEAT_XOR_CHUNK + 1];
+	size_t text_len = 0;
+
+	switch (format) {
+	case OUTPUT_RAW:
+		return fwrite(bytes, 1, len, stdout) == len;
+	case OUTPUT_HEX:
+		if (bytes_to_hex(bytes, len, text, sizeof(text)) != UTILS_OK) {
+			return 0;
+		}
+		text_len = 2 * len;
+		break;
+	case OUTPUT_BASE64:
+		if (bytes_to_base64(bytes, len, (uint8_t *) text,
+			sizeof(text), &text_len) != HEX2B64_OK) {
+			return 0;
+		}
+		break;
+	}
+	return fwrite(text, 1, text_len, stdout) == text_len;
+}
+
+int
+main(int argc, char **argv)
+{
+	output_format format = OUTPUT_RAW;
+	int argi = 1;
+
+	stats_dump_at_exit();
+
+	if (argc == 3 && strcmp(argv[1], "-x") == 0) {
+		format = OUTPUT_HEX;
+		argi = 2;
+	} else if (argc == 3 && strcmp(argv[1], "-b") == 0) {
+		format = OUTPUT_BASE64;
+		argi = 2;
+	} else if (argc != 2 || argv[1][0] == '-') {
+		usage();
+		return EXIT_FAILURE;
+	}
+
+	const char *key = argv[argi];
+	repeat_xor_ctx ctx;
+	repeat_xor_status status = repeat_xor_init(&ctx, (const uint8_t *) key,
+	    strlen(key));
+	if (status != REPEAT_XOR_OK) {
+		fprintf(stderr, "repeat_xor: %s\n",
+		    repeat_xor_status_string(status));
+		return EXIT_FAILURE;
+	}
+
+	static uint8_t chunk[REPEAT_XOR_CHUNK];
+	size_t nread;
+	while ((nread = fread(chunk, 1, sizeof(chunk), stdin)) > 0) {
+		repeat_xor_update(&ctx, chunk, chunk, nread);
+		if (!write_chunk(format, chunk, nread)) {
+			fprintf(stderr, "repeat_xor: write failed\n");
+			return EXIT_FAILURE;
+		}
+	}
+	if (ferror(stdin)) {
+		fprintf(stderr, "repeat_xor: read failed\n");
+		return EXIT_FAILURE;
+	}
+
+	if (format != OUTPUT_RAW && fputc('\n', stdout) == EOF) {
+		fprintf(stderr, "repeat_xor: write failed\n");
+		return EXIT_FAILURE;
+	}
+	if (fflush(stdout) != 0) {
+		fprintf(stderr, "repeat_xor: write failed\n");
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}